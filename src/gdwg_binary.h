@@ -0,0 +1,417 @@
+#ifndef GDWG_BINARY_H
+#define GDWG_BINARY_H
+
+#include "gdwg_frozen_graph.h"
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gdwg {
+	// The file format written by save_binary() and read by load_binary().
+	//
+	// A file is a header followed by six sections, each starting on a 64-byte boundary. Integers are little-endian.
+	// Nodes are stored in ascending order and named by their rank, as in frozen_graph:
+	//   nodes     node_count node values
+	//   offsets   node_count + 1 uint64s: the outgoing edges of node i are [offsets[i], offsets[i + 1])
+	//   dsts      edge_count uint32 destination ranks, in edge order
+	//   weighted  edge_count bytes, 1 for a weighted edge and 0 for an unweighted one
+	//   weights   edge_count weight values, all zero bytes for an unweighted edge
+	//   strings   the characters of every std::string node and weight
+	// An arithmetic value is stored as its bytes, and a std::string as a string_ref into the strings section.
+	// Every section is an array of fixed-size records, so a mapped file can be queried where it lies.
+	namespace binary {
+		inline constexpr auto magic = std::array<char, 8>{'G', 'D', 'W', 'G', 'B', 'I', 'N', '\0'};
+		inline constexpr auto version = std::uint32_t{2};
+		inline constexpr auto alignment = std::uint64_t{64};
+
+		enum section_id : std::size_t {
+			node_section,
+			offset_section,
+			dst_section,
+			weighted_section,
+			weight_section,
+			string_section,
+			section_count,
+		};
+
+		enum class value_kind : std::uint32_t {
+			boolean = 1,
+			character = 2,
+			signed_integer = 3,
+			unsigned_integer = 4,
+			floating_point = 5,
+			string = 6,
+		};
+
+		// What a node or weight type is: its kind and the size of its record. Types with the same kind and size
+		// store their values the same way, so a file is only read back as types that mean what it was written with.
+		struct value_type {
+			value_kind kind;
+			std::uint32_t size;
+
+			auto operator==(value_type const&) const -> bool = default;
+		};
+
+		struct section {
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+
+		struct header {
+			std::array<char, 8> magic;
+			std::uint32_t version;
+			std::uint32_t header_size;
+			value_type node_type;
+			value_type weight_type;
+			std::uint64_t node_count;
+			std::uint64_t edge_count;
+			std::array<section, section_count> sections;
+		};
+
+		// A std::string value: characters [offset, offset + size) of the strings section.
+		struct string_ref {
+			std::uint64_t offset;
+			std::uint64_t size;
+		};
+
+		template<typename T>
+		concept character = std::same_as<T, char> or std::same_as<T, wchar_t> or std::same_as<T, char8_t>
+		                     or std::same_as<T, char16_t> or std::same_as<T, char32_t>;
+
+		// Types whose values can be stored: arithmetic types, whose bytes are their value, and std::string. Other
+		// trivially copyable types are left out, since their bytes may hold pointers or padding.
+		template<typename T>
+		concept encodable = std::same_as<T, std::string> or std::is_arithmetic_v<T>;
+
+		// The record a value of type T is stored as.
+		template<typename T>
+		using stored_t = std::conditional_t<std::same_as<T, std::string>, string_ref, T>;
+
+		template<typename T>
+		constexpr auto kind_of() -> value_kind {
+			if constexpr (std::same_as<T, std::string>) {
+				return value_kind::string;
+			}
+			else if constexpr (std::same_as<T, bool>) {
+				return value_kind::boolean;
+			}
+			else if constexpr (character<T>) {
+				return value_kind::character;
+			}
+			else if constexpr (std::floating_point<T>) {
+				return value_kind::floating_point;
+			}
+			else if constexpr (std::is_signed_v<T>) {
+				return value_kind::signed_integer;
+			}
+			else {
+				return value_kind::unsigned_integer;
+			}
+		}
+
+		template<typename T>
+		constexpr auto type_of() -> value_type {
+			return {kind_of<T>(), static_cast<std::uint32_t>(sizeof(stored_t<T>))};
+		}
+
+		constexpr auto align(std::uint64_t offset) -> std::uint64_t {
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		// Reads the T stored at p, which need not be aligned for T.
+		template<typename T>
+		auto read(char const* p) -> T {
+			auto bytes = std::array<char, sizeof(T)>{};
+			std::memcpy(bytes.data(), p, sizeof(T));
+			return std::bit_cast<T>(bytes);
+		}
+
+		template<typename T>
+		auto append(std::vector<char>& out, T const& value) -> void {
+			auto const size = out.size();
+			out.resize(size + sizeof(T));
+			std::memcpy(out.data() + size, &value, sizeof(T));
+		}
+
+		// Appends the bytes of every value in order. Nothing is copied from an empty vector, whose data() may be null.
+		template<typename T>
+		auto append_all(std::vector<char>& out, std::vector<T> const& values) -> void {
+			auto const* bytes = reinterpret_cast<char const*>(values.data());
+			out.insert(out.end(), bytes, bytes + values.size() * sizeof(T));
+		}
+
+		// Appends the record of value to out, and the characters of a std::string to strings.
+		template<typename T>
+		auto store(std::vector<char>& out, std::vector<char>& strings, T const& value) -> void {
+			if constexpr (std::same_as<T, std::string>) {
+				append(out, string_ref{strings.size(), value.size()});
+				strings.insert(strings.end(), value.begin(), value.end());
+			}
+			else {
+				append(out, value);
+			}
+		}
+
+		// A file in memory whose header and section bounds have been checked.
+		struct layout {
+			header head;
+			char const* data;
+
+			auto section_data(section_id id) const -> char const* {
+				return data + head.sections[id].offset;
+			}
+		};
+
+		[[noreturn]] inline auto fail(std::string_view caller, std::string_view reason) -> void {
+			throw std::runtime_error("Cannot call " + std::string(caller) + " on " + std::string(reason));
+		}
+
+		// Checks the header and that every section lies in the file with the size the counts call for. Costs O(1),
+		// so a mapped file can be opened without touching its sections.
+		template<typename N, typename E>
+		auto parse(char const* data, std::size_t size, std::string_view caller) -> layout {
+			if (size < sizeof(header)) {
+				fail(caller, "a file that is not a binary graph");
+			}
+			auto const head = read<header>(data);
+			if (head.magic != magic) {
+				fail(caller, "a file that is not a binary graph");
+			}
+			if (head.version != version or head.header_size != sizeof(header)) {
+				fail(caller, "a binary graph of another version");
+			}
+			if (head.node_type != type_of<N>() or head.weight_type != type_of<E>()) {
+				fail(caller, "a binary graph of other node or weight types");
+			}
+
+			// Every node and edge takes at least one byte, which also keeps the sizes below from overflowing.
+			auto const file_size = std::uint64_t{size};
+			if (head.node_count > file_size or head.edge_count > file_size) {
+				fail(caller, "a corrupt binary graph");
+			}
+			auto expected = std::array<std::uint64_t, section_count>{};
+			expected[node_section] = head.node_count * sizeof(stored_t<N>);
+			expected[offset_section] = (head.node_count + 1) * sizeof(std::uint64_t);
+			expected[dst_section] = head.edge_count * sizeof(std::uint32_t);
+			expected[weighted_section] = head.edge_count;
+			expected[weight_section] = head.edge_count * sizeof(stored_t<E>);
+			expected[string_section] = head.sections[string_section].size;
+			for (auto id = std::size_t{0}; id < section_count; ++id) {
+				auto const [offset, section_size] = head.sections[id];
+				if (section_size != expected[id] or offset % alignment != 0 or offset < sizeof(header)
+				    or section_size > file_size or offset > file_size - section_size)
+				{
+					fail(caller, "a corrupt binary graph");
+				}
+			}
+			return {head, data};
+		}
+
+		// Whether the count records of a section are valid Ts: string references inside the string pool, and bools of
+		// 0 or 1. Any bytes are a valid value of the other types.
+		template<typename T>
+		auto check_values(layout const& file, section_id id, std::uint64_t count) -> bool {
+			if constexpr (std::same_as<T, bool>) {
+				auto const* values = file.section_data(id);
+				for (auto i = std::uint64_t{0}; i < count; ++i) {
+					if (values[i] != 0 and values[i] != 1) {
+						return false;
+					}
+				}
+			}
+			else if constexpr (std::same_as<T, std::string>) {
+				auto const pool_size = file.head.sections[string_section].size;
+				for (auto i = std::uint64_t{0}; i < count; ++i) {
+					auto const ref = read<string_ref>(file.section_data(id) + i * sizeof(string_ref));
+					if (ref.size > pool_size or ref.offset > pool_size - ref.size) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// Checks that the offsets, destinations, weight flags and string references all point inside the file, and
+		// that every stored bool is 0 or 1. Costs O(V + E), without allocating.
+		template<typename N, typename E>
+		auto check_contents(layout const& file, std::string_view caller) -> void {
+			auto const node_count = file.head.node_count;
+			auto const edge_count = file.head.edge_count;
+			auto const* offsets = file.section_data(offset_section);
+			auto previous = std::uint64_t{0};
+			for (auto i = std::uint64_t{0}; i <= node_count; ++i) {
+				auto const offset = read<std::uint64_t>(offsets + i * sizeof(std::uint64_t));
+				if (offset < previous or (i == 0 and offset != 0) or offset > edge_count) {
+					fail(caller, "a corrupt binary graph");
+				}
+				previous = offset;
+			}
+			if (previous != edge_count) {
+				fail(caller, "a corrupt binary graph");
+			}
+
+			auto const* dsts = file.section_data(dst_section);
+			auto const* weighted = file.section_data(weighted_section);
+			for (auto i = std::uint64_t{0}; i < edge_count; ++i) {
+				auto const dst = read<std::uint32_t>(dsts + i * sizeof(std::uint32_t));
+				if (dst >= node_count or (weighted[i] != 0 and weighted[i] != 1)) {
+					fail(caller, "a corrupt binary graph");
+				}
+			}
+
+			if (not check_values<N>(file, node_section, node_count)
+			    or not check_values<E>(file, weight_section, edge_count))
+			{
+				fail(caller, "a corrupt binary graph");
+			}
+		}
+
+		// The value of type T stored at index i of a section.
+		template<typename T>
+		auto decode(layout const& file, section_id id, std::uint64_t i) -> T {
+			auto const stored = read<stored_t<T>>(file.section_data(id) + i * sizeof(stored_t<T>));
+			if constexpr (std::same_as<T, std::string>) {
+				return std::string(file.section_data(string_section) + stored.offset, stored.size);
+			}
+			else {
+				return stored;
+			}
+		}
+	} // namespace binary
+
+	// Writes g to path in the binary format above, replacing the file if it exists. Nodes and weights must be
+	// arithmetic types or std::string. Costs O(V log V + E).
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	auto save_binary(graph<N, E> const& g, std::filesystem::path const& path) -> void {
+		static_assert(std::endian::native == std::endian::little, "binary graphs are stored little-endian");
+
+		auto sections = std::array<std::vector<char>, binary::section_count>();
+		auto& strings = sections[binary::string_section];
+
+		auto const nodes = g.nodes();
+		for (auto const& node : nodes) {
+			binary::store(sections[binary::node_section], strings, node);
+		}
+
+		auto dsts = std::vector<std::uint32_t>{};
+		auto& weighted = sections[binary::weighted_section];
+		auto& weights = sections[binary::weight_section];
+		auto const offsets = for_each_csr_edge(g, nodes, [&](std::uint32_t dst, E const* weight) {
+			dsts.push_back(dst);
+			weighted.push_back(weight != nullptr ? char{1} : char{0});
+			if (weight != nullptr) {
+				binary::store(weights, strings, *weight);
+			}
+			else {
+				weights.resize(weights.size() + sizeof(binary::stored_t<E>));
+			}
+		});
+		sections[binary::offset_section].reserve(offsets.size() * sizeof(std::uint64_t));
+		for (auto const offset : offsets) {
+			binary::append(sections[binary::offset_section], std::uint64_t{offset});
+		}
+		binary::append_all(sections[binary::dst_section], dsts);
+
+		auto head = binary::header{binary::magic,
+		                           binary::version,
+		                           sizeof(binary::header),
+		                           binary::type_of<N>(),
+		                           binary::type_of<E>(),
+		                           nodes.size(),
+		                           dsts.size(),
+		                           {}};
+		auto position = binary::align(sizeof(binary::header));
+		for (auto id = std::size_t{0}; id < binary::section_count; ++id) {
+			head.sections[id] = {position, sections[id].size()};
+			position = binary::align(position + sections[id].size());
+		}
+
+		auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		auto const padding = std::array<char, binary::alignment>{};
+		auto written = std::uint64_t{sizeof(binary::header)};
+		file.write(reinterpret_cast<char const*>(&head), sizeof(binary::header));
+		for (auto id = std::size_t{0}; id < binary::section_count; ++id) {
+			file.write(padding.data(), static_cast<std::streamsize>(head.sections[id].offset - written));
+			file.write(sections[id].data(), static_cast<std::streamsize>(sections[id].size()));
+			written = head.sections[id].offset + sections[id].size();
+		}
+		if (not file.flush()) {
+			binary::fail("gdwg::save_binary", "a file that cannot be written");
+		}
+	}
+
+	// Reads a graph written by save_binary() with the same node and weight types. Throws std::runtime_error if the
+	// file cannot be read, was written with other types, or is damaged. Costs O(V + E) besides building the graph,
+	// whose edges arrive already in order.
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	auto load_binary(std::filesystem::path const& path) -> graph<N, E> {
+		static_assert(std::endian::native == std::endian::little, "binary graphs are stored little-endian");
+		constexpr auto caller = std::string_view("gdwg::load_binary");
+
+		auto error = std::error_code{};
+		auto const size = std::filesystem::file_size(path, error);
+		auto file = std::ifstream(path, std::ios::binary);
+		auto data = std::vector<char>(error ? 0 : size);
+		if (error or not file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+			binary::fail(caller, "a file that cannot be read");
+		}
+		auto const layout = binary::parse<N, E>(data.data(), data.size(), caller);
+		binary::check_contents<N, E>(layout, caller);
+
+		auto const node_count = layout.head.node_count;
+		auto nodes = std::vector<N>{};
+		nodes.reserve(node_count);
+		for (auto i = std::uint64_t{0}; i < node_count; ++i) {
+			nodes.push_back(binary::decode<N>(layout, binary::node_section, i));
+		}
+		// Ranks only name the right nodes if the nodes are stored in ascending order.
+		if (std::adjacent_find(nodes.begin(), nodes.end(), [](N const& lhs, N const& rhs) { return not(lhs < rhs); })
+		    != nodes.end())
+		{
+			binary::fail(caller, "a corrupt binary graph");
+		}
+
+		auto const* offsets = layout.section_data(binary::offset_section);
+		auto const* dsts = layout.section_data(binary::dst_section);
+		auto const* weighted = layout.section_data(binary::weighted_section);
+		auto batch = std::vector<std::tuple<N const&, N const&, std::optional<E>>>{};
+		batch.reserve(layout.head.edge_count);
+		for (auto src = std::uint64_t{0}; src < node_count; ++src) {
+			auto const first = binary::read<std::uint64_t>(offsets + src * sizeof(std::uint64_t));
+			auto const last = binary::read<std::uint64_t>(offsets + (src + 1) * sizeof(std::uint64_t));
+			for (auto i = first; i < last; ++i) {
+				auto const dst = binary::read<std::uint32_t>(dsts + i * sizeof(std::uint32_t));
+				auto weight = std::optional<E>{};
+				if (weighted[i] != 0) {
+					weight = binary::decode<E>(layout, binary::weight_section, i);
+				}
+				batch.emplace_back(nodes[src], nodes[dst], std::move(weight));
+			}
+		}
+
+		auto g = graph<N, E>(nodes.begin(), nodes.end());
+		g.insert_edges(batch.begin(), batch.end());
+		return g;
+	}
+} // namespace gdwg
+
+#endif // GDWG_BINARY_H
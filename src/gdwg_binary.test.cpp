@@ -0,0 +1,190 @@
+#include "gdwg_binary.h"
+#include "gdwg_test_helpers.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using gdwg::test::sample_graph;
+using gdwg::test::temp_file;
+
+namespace {
+	auto read_bytes(std::filesystem::path const& path) -> std::vector<char> {
+		auto file = std::ifstream(path, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	auto write_bytes(std::filesystem::path const& path, std::vector<char> const& bytes) -> void {
+		auto file = std::ofstream(path, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+} // namespace
+
+TEST_CASE("load_binary reads back the graph save_binary wrote", "[binary]") {
+	auto const file = temp_file("round_trip");
+
+	SECTION("string nodes and int weights") {
+		auto const g = sample_graph();
+		gdwg::save_binary(g, file.path);
+		REQUIRE(gdwg::load_binary<std::string, int>(file.path) == g);
+	}
+
+	SECTION("int nodes and string weights") {
+		auto g = gdwg::graph<int, std::string>{-3, 0, 7, 10};
+		g.insert_edge(10, -3, "ten to minus three");
+		g.insert_edge(10, -3);
+		g.insert_edge(0, 0, "");
+		g.insert_edge(7, 10, "seven");
+		gdwg::save_binary(g, file.path);
+		REQUIRE(gdwg::load_binary<int, std::string>(file.path) == g);
+	}
+
+	SECTION("double weights") {
+		auto g = gdwg::graph<int, double>{1, 2};
+		g.insert_edge(1, 2, 0.5);
+		g.insert_edge(1, 2, -1.25);
+		g.insert_edge(2, 1);
+		gdwg::save_binary(g, file.path);
+		REQUIRE(gdwg::load_binary<int, double>(file.path) == g);
+	}
+
+	SECTION("char nodes and bool weights") {
+		auto g = gdwg::graph<char, bool>{'a', 'b'};
+		g.insert_edge('a', 'b', true);
+		g.insert_edge('a', 'b', false);
+		g.insert_edge('b', 'b');
+		gdwg::save_binary(g, file.path);
+		REQUIRE(gdwg::load_binary<char, bool>(file.path) == g);
+	}
+
+	SECTION("nodes without edges") {
+		auto const g = gdwg::graph<std::string, int>{"lonely", "", "alone"};
+		gdwg::save_binary(g, file.path);
+		REQUIRE(gdwg::load_binary<std::string, int>(file.path) == g);
+	}
+
+	SECTION("an empty graph") {
+		gdwg::save_binary(gdwg::graph<int, int>{}, file.path);
+		REQUIRE(gdwg::load_binary<int, int>(file.path).empty());
+	}
+}
+
+TEST_CASE("only arithmetic types and std::string can be stored", "[binary]") {
+	struct holds_pointer {
+		int const* p;
+	};
+	STATIC_REQUIRE(gdwg::binary::encodable<int>);
+	STATIC_REQUIRE(gdwg::binary::encodable<double>);
+	STATIC_REQUIRE(gdwg::binary::encodable<std::string>);
+	STATIC_REQUIRE_FALSE(gdwg::binary::encodable<std::string_view>);
+	STATIC_REQUIRE_FALSE(gdwg::binary::encodable<int const*>);
+	STATIC_REQUIRE_FALSE(gdwg::binary::encodable<holds_pointer>);
+}
+
+TEST_CASE("save_binary lays the sections out on 64-byte boundaries", "[binary]") {
+	auto const file = temp_file("layout");
+	gdwg::save_binary(sample_graph(), file.path);
+	auto const bytes = read_bytes(file.path);
+
+	auto const head = gdwg::binary::read<gdwg::binary::header>(bytes.data());
+	REQUIRE(head.magic == gdwg::binary::magic);
+	REQUIRE(head.version == gdwg::binary::version);
+	REQUIRE(head.node_count == 4);
+	REQUIRE(head.edge_count == 6);
+	for (auto const& [offset, size] : head.sections) {
+		REQUIRE(offset % 64 == 0);
+		REQUIRE(offset + size <= bytes.size());
+	}
+
+	// Edges of C, node 2, start after A's four and B's none.
+	auto const* offsets = bytes.data() + head.sections[gdwg::binary::offset_section].offset;
+	REQUIRE(gdwg::binary::read<std::uint64_t>(offsets + 2 * sizeof(std::uint64_t)) == 4);
+	auto const* dsts = bytes.data() + head.sections[gdwg::binary::dst_section].offset;
+	REQUIRE(gdwg::binary::read<std::uint32_t>(dsts + 4 * sizeof(std::uint32_t)) == 0);
+	REQUIRE(head.sections[gdwg::binary::string_section].size == 4);
+}
+
+TEST_CASE("load_binary rejects files it cannot read back", "[binary]") {
+	auto const file = temp_file("rejected");
+	gdwg::save_binary(sample_graph(), file.path);
+	auto bytes = read_bytes(file.path);
+
+	SECTION("a missing file") {
+		REQUIRE_THROWS_WITH((gdwg::load_binary<std::string, int>(file.path.string() + ".missing")),
+		                    "Cannot call gdwg::load_binary on a file that cannot be read");
+	}
+
+	SECTION("a file that is not a binary graph") {
+		write_bytes(file.path, std::vector<char>{'A', ' ', '-', '>', ' ', 'B'});
+		REQUIRE_THROWS_WITH((gdwg::load_binary<std::string, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a file that is not a binary graph");
+	}
+
+	SECTION("another version") {
+		bytes[8] = static_cast<char>(gdwg::binary::version + 1);
+		write_bytes(file.path, bytes);
+		REQUIRE_THROWS_WITH((gdwg::load_binary<std::string, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a binary graph of another version");
+	}
+
+	SECTION("other node or weight types") {
+		REQUIRE_THROWS_WITH((gdwg::load_binary<int, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a binary graph of other node or weight types");
+		REQUIRE_THROWS_WITH((gdwg::load_binary<std::string, double>(file.path)),
+		                    "Cannot call gdwg::load_binary on a binary graph of other node or weight types");
+	}
+
+	SECTION("other arithmetic types of the same size") {
+		auto g = gdwg::graph<int, int>{1, 2};
+		g.insert_edge(1, 2, 3);
+		gdwg::save_binary(g, file.path);
+		REQUIRE_THROWS_WITH((gdwg::load_binary<float, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a binary graph of other node or weight types");
+		REQUIRE_THROWS_WITH((gdwg::load_binary<unsigned, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a binary graph of other node or weight types");
+		REQUIRE_THROWS_WITH((gdwg::load_binary<int, char32_t>(file.path)),
+		                    "Cannot call gdwg::load_binary on a binary graph of other node or weight types");
+	}
+
+	SECTION("a bool weight that is neither 0 nor 1") {
+		auto g = gdwg::graph<int, bool>{1, 2};
+		g.insert_edge(1, 2, true);
+		gdwg::save_binary(g, file.path);
+		bytes = read_bytes(file.path);
+		auto const head = gdwg::binary::read<gdwg::binary::header>(bytes.data());
+		bytes[head.sections[gdwg::binary::weight_section].offset] = 2;
+		write_bytes(file.path, bytes);
+		REQUIRE_THROWS_WITH((gdwg::load_binary<int, bool>(file.path)),
+		                    "Cannot call gdwg::load_binary on a corrupt binary graph");
+	}
+
+	SECTION("a truncated file") {
+		bytes.pop_back();
+		write_bytes(file.path, bytes);
+		REQUIRE_THROWS_WITH((gdwg::load_binary<std::string, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a corrupt binary graph");
+	}
+
+	SECTION("a destination out of range") {
+		auto const head = gdwg::binary::read<gdwg::binary::header>(bytes.data());
+		bytes[head.sections[gdwg::binary::dst_section].offset] = 4;
+		write_bytes(file.path, bytes);
+		REQUIRE_THROWS_WITH((gdwg::load_binary<std::string, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a corrupt binary graph");
+	}
+
+	SECTION("nodes out of order") {
+		auto const head = gdwg::binary::read<gdwg::binary::header>(bytes.data());
+		bytes[head.sections[gdwg::binary::string_section].offset] = 'E';
+		write_bytes(file.path, bytes);
+		REQUIRE_THROWS_WITH((gdwg::load_binary<std::string, int>(file.path)),
+		                    "Cannot call gdwg::load_binary on a corrupt binary graph");
+	}
+}
@@ -0,0 +1,340 @@
+#ifndef GDWG_FROZEN_GRAPH_H
+#define GDWG_FROZEN_GRAPH_H
+
+#include "gdwg_graph.h"
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gdwg {
+	// An immutable snapshot of a graph in compressed sparse row (CSR) form: the outgoing edges of node i occupy
+	// [offsets[i], offsets[i + 1]) in the contiguous destination and weight arrays. Node ids are the ranks of the
+	// nodes in ascending order, so comparing ids is the same as comparing nodes.
+	//
+	// Taking a frozen_graph reads the whole graph, in O(V + E). Copies of it then share the arrays, which are never
+	// modified, so one snapshot can be handed to any number of readers in O(1) while the graph keeps changing.
+	// A graph that keeps changing is better snapshotted with graph::snapshot(), which is O(1) and leaves each later
+	// write to copy only the blocks it touches.
+	template<typename N, typename E>
+	class frozen_graph {
+		struct storage;
+
+	 public:
+		using edge = gdwg::edge<N, E>;
+		using node_id = std::uint32_t;
+
+		class iterator {
+		 public:
+			using value_type = struct {
+				N from;
+				N to;
+				std::optional<E> weight;
+			};
+			using reference = value_type;
+			using pointer = void;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::random_access_iterator_tag;
+
+			iterator() = default;
+
+			// Iterator source
+			auto operator*() const -> reference {
+				return {g_->nodes[src_], g_->nodes[g_->dsts[index_]], g_->weights[index_]};
+			}
+			auto operator[](difference_type n) const -> reference {
+				return *(*this + n);
+			}
+
+			// Iterator traversal
+			auto operator++() -> iterator& {
+				++index_;
+				skip_exhausted_sources();
+				return *this;
+			}
+			auto operator++(int) -> iterator {
+				auto temp = *this;
+				++*this;
+				return temp;
+			}
+			auto operator--() -> iterator& {
+				--index_;
+				while (g_->offsets[src_] > index_) {
+					--src_;
+				}
+				return *this;
+			}
+			auto operator--(int) -> iterator {
+				auto temp = *this;
+				--*this;
+				return temp;
+			}
+			// Jumps find the new source with a binary search over the offsets, so splitting the edges into chunks
+			// costs O(log V) per chunk.
+			auto operator+=(difference_type n) -> iterator& {
+				index_ = static_cast<std::size_t>(static_cast<difference_type>(index_) + n);
+				auto const next = std::upper_bound(g_->offsets.begin(), g_->offsets.end(), index_);
+				src_ = static_cast<std::size_t>(next - g_->offsets.begin() - 1);
+				return *this;
+			}
+			auto operator-=(difference_type n) -> iterator& {
+				return *this += -n;
+			}
+			friend auto operator+(iterator it, difference_type n) -> iterator {
+				return it += n;
+			}
+			friend auto operator+(difference_type n, iterator it) -> iterator {
+				return it += n;
+			}
+			friend auto operator-(iterator it, difference_type n) -> iterator {
+				return it -= n;
+			}
+			auto operator-(iterator const& other) const -> difference_type {
+				return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+			}
+
+			// Iterator comparison
+			auto operator==(iterator const& other) const -> bool {
+				return index_ == other.index_;
+			}
+			auto operator<=>(iterator const& other) const -> std::strong_ordering {
+				return index_ <=> other.index_;
+			}
+
+		 private:
+			iterator(storage const* g, std::size_t src, std::size_t index)
+			: g_(g)
+			, src_(src)
+			, index_(index) {
+				skip_exhausted_sources();
+			}
+
+			auto skip_exhausted_sources() -> void {
+				while (src_ < g_->nodes.size() and g_->offsets[src_ + 1] <= index_) {
+					++src_;
+				}
+			}
+
+			// The shared arrays rather than the frozen_graph, so iterators outlive the copy they came from.
+			storage const* g_ = nullptr;
+			std::size_t src_ = 0;
+			std::size_t index_ = 0;
+			friend class frozen_graph<N, E>;
+		};
+
+		frozen_graph();
+		explicit frozen_graph(graph<N, E> const& g);
+
+		[[nodiscard]] auto is_node(N const& value) const -> bool;
+		[[nodiscard]] auto empty() const noexcept -> bool;
+		[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
+		[[nodiscard]] auto nodes() const -> std::vector<N>;
+		[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const -> iterator;
+		[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+
+		[[nodiscard]] auto begin() const -> iterator;
+		[[nodiscard]] auto end() const -> iterator;
+
+	 private:
+		struct storage {
+			std::vector<N> nodes;
+			std::vector<std::size_t> offsets;
+			std::vector<node_id> dsts;
+			std::vector<std::optional<E>> weights;
+		};
+
+		auto find_node(N const& value) const -> std::optional<node_id>;
+		// Range of src's outgoing edges to dst, ordered by weight with the unweighted edge first.
+		auto edge_range(node_id src, node_id dst) const -> std::pair<std::size_t, std::size_t>;
+
+		std::shared_ptr<storage const> data_;
+	};
+
+	// Visits g's edges in CSR order. Calls fn(dst, weight) for every edge, where dst is the rank of the destination
+	// in nodes, which must be g.nodes(), and weight is null for an unweighted edge. Returns the offsets: the edges of
+	// node i are calls [offsets[i], offsets[i + 1]).
+	//
+	// Graph iteration is ordered by (src, dst, weight), which is exactly CSR order once nodes are ranked. Edges are
+	// read in place, and each destination is ranked by a binary search only the first time it is seen: after that it
+	// is found by the address of the graph's node object.
+	template<typename N, typename E, typename F>
+	auto for_each_csr_edge(graph<N, E> const& g, std::vector<N> const& nodes, F fn) -> std::vector<std::size_t> {
+		auto offsets = std::vector<std::size_t>(nodes.size() + 1, 0);
+		auto ranks = std::unordered_map<N const*, std::uint32_t>{};
+		ranks.reserve(nodes.size());
+		auto src = std::size_t{0};
+		auto count = std::size_t{0};
+		auto const* last_from = static_cast<N const*>(nullptr);
+		for (auto const& [from, to, weight] : g.edge_refs()) {
+			if (&from != last_from) {
+				while (nodes[src] != from) {
+					offsets[++src] = count;
+				}
+				last_from = &from;
+			}
+			auto [rank, inserted] = ranks.try_emplace(&to, std::uint32_t{0});
+			if (inserted) {
+				auto const it = std::lower_bound(nodes.begin(), nodes.end(), to);
+				rank->second = static_cast<std::uint32_t>(it - nodes.begin());
+			}
+			fn(rank->second, weight);
+			++count;
+		}
+		while (src < nodes.size()) {
+			offsets[++src] = count;
+		}
+		return offsets;
+	}
+
+	// Implementation of frozen_graph member functions
+	template<typename N, typename E>
+	frozen_graph<N, E>::frozen_graph() {
+		auto data = std::make_shared<storage>();
+		data->offsets.assign(1, 0);
+		data_ = std::move(data);
+	}
+
+	template<typename N, typename E>
+	frozen_graph<N, E>::frozen_graph(graph<N, E> const& g) {
+		auto data = std::make_shared<storage>();
+		auto& [nodes, offsets, dsts, weights] = *data;
+		nodes = g.nodes();
+		offsets = for_each_csr_edge(g, nodes, [&dsts, &weights](node_id dst, E const* weight) {
+			dsts.push_back(dst);
+			weights.push_back(weight != nullptr ? std::optional<E>(*weight) : std::nullopt);
+		});
+		data_ = std::move(data);
+	}
+
+	template<typename N, typename E>
+	auto frozen_graph<N, E>::find_node(N const& value) const -> std::optional<node_id> {
+		auto const& nodes = data_->nodes;
+		auto it = std::lower_bound(nodes.begin(), nodes.end(), value);
+		if (it == nodes.end() or *it != value) {
+			return std::nullopt;
+		}
+		return static_cast<node_id>(it - nodes.begin());
+	}
+
+	template<typename N, typename E>
+	auto frozen_graph<N, E>::edge_range(node_id src, node_id dst) const -> std::pair<std::size_t, std::size_t> {
+		auto const& dsts = data_->dsts;
+		auto const first = dsts.begin() + static_cast<std::ptrdiff_t>(data_->offsets[src]);
+		auto const last = dsts.begin() + static_cast<std::ptrdiff_t>(data_->offsets[src + 1]);
+		auto const [lower, upper] = std::equal_range(first, last, dst);
+		return {static_cast<std::size_t>(lower - dsts.begin()), static_cast<std::size_t>(upper - dsts.begin())};
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::is_node(N const& value) const -> bool {
+		return find_node(value).has_value();
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::empty() const noexcept -> bool {
+		return data_->nodes.empty();
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::is_connected(N const& src, N const& dst) const -> bool {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
+			throw std::runtime_error("Cannot call gdwg::frozen_graph<N, E>::is_connected if src or dst node don't "
+			                         "exist in the graph");
+		}
+
+		auto const [first, last] = edge_range(*src_id, *dst_id);
+		return first != last;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::nodes() const -> std::vector<N> {
+		return data_->nodes;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::edges(N const& src, N const& dst) const
+	    -> std::vector<std::unique_ptr<edge>> {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
+			throw std::runtime_error("Cannot call gdwg::frozen_graph<N, E>::edges if src or dst node don't exist in "
+			                         "the graph");
+		}
+
+		auto const& weights = data_->weights;
+		auto const [first, last] = edge_range(*src_id, *dst_id);
+		auto result = std::vector<std::unique_ptr<edge>>{};
+		result.reserve(last - first);
+		for (auto i = first; i != last; ++i) {
+			if (weights[i]) {
+				result.push_back(std::make_unique<weighted_edge<N, E>>(src, dst, *weights[i]));
+			}
+			else {
+				result.push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+			}
+		}
+		return result;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const
+	    -> iterator {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
+			return end();
+		}
+
+		auto const& weights = data_->weights;
+		auto const [first, last] = edge_range(*src_id, *dst_id);
+		auto const weights_first = weights.begin() + static_cast<std::ptrdiff_t>(first);
+		auto const weights_last = weights.begin() + static_cast<std::ptrdiff_t>(last);
+		// std::optional orders nullopt before every value, matching the unweighted-first edge order.
+		auto const it = std::lower_bound(weights_first, weights_last, weight);
+		if (it == weights_last or *it != weight) {
+			return end();
+		}
+		return iterator(data_.get(), *src_id, static_cast<std::size_t>(it - weights.begin()));
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::connections(N const& src) const -> std::vector<N> {
+		auto const src_id = find_node(src);
+		if (not src_id) {
+			throw std::runtime_error("Cannot call gdwg::frozen_graph<N, E>::connections if src doesn't exist in the "
+			                         "graph");
+		}
+
+		auto const& [nodes, offsets, dsts, weights] = *data_;
+		auto result = std::vector<N>{};
+		result.reserve(offsets[*src_id + 1] - offsets[*src_id]);
+		for (auto i = offsets[*src_id]; i != offsets[*src_id + 1]; ++i) {
+			result.push_back(nodes[dsts[i]]);
+		}
+		return result;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::begin() const -> iterator {
+		return iterator(data_.get(), 0, 0);
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto frozen_graph<N, E>::end() const -> iterator {
+		return iterator(data_.get(), data_->nodes.size(), data_->dsts.size());
+	}
+
+} // namespace gdwg
+
+#endif // GDWG_FROZEN_GRAPH_H
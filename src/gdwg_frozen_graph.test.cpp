@@ -0,0 +1,179 @@
+#include "gdwg_frozen_graph.h"
+#include "gdwg_test_helpers.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+using gdwg::test::sample_graph;
+
+TEST_CASE("Default constructed frozen_graph is empty", "[frozen_graph]") {
+	auto const fg = gdwg::frozen_graph<std::string, int>{};
+
+	REQUIRE(fg.empty());
+	REQUIRE(fg.nodes().empty());
+	REQUIRE(fg.begin() == fg.end());
+}
+
+TEST_CASE("frozen_graph keeps the nodes of the graph", "[frozen_graph]") {
+	auto const g = sample_graph();
+	auto const fg = gdwg::frozen_graph<std::string, int>(g);
+
+	REQUIRE_FALSE(fg.empty());
+	REQUIRE(fg.nodes() == g.nodes());
+	REQUIRE(fg.is_node("D"));
+	REQUIRE_FALSE(fg.is_node("E"));
+}
+
+TEST_CASE("frozen_graph iterates edges in the same order as the graph", "[frozen_graph][iterator]") {
+	auto const g = sample_graph();
+	auto const fg = gdwg::frozen_graph<std::string, int>(g);
+
+	REQUIRE(std::distance(fg.begin(), fg.end()) == std::distance(g.begin(), g.end()));
+	auto it = g.begin();
+	for (auto const& [from, to, weight] : fg) {
+		auto const expected = *it++;
+		REQUIRE(from == expected.from);
+		REQUIRE(to == expected.to);
+		REQUIRE(weight == expected.weight);
+	}
+
+	SECTION("Iterating backwards") {
+		auto last = fg.end();
+		--last;
+		REQUIRE((*last).from == "C");
+		REQUIRE((*last).to == "C");
+		last--;
+		REQUIRE((*last).from == "C");
+		REQUIRE((*last).to == "A");
+		REQUIRE((*last).weight == 5);
+	}
+}
+
+TEST_CASE("frozen_graph iterators are random access", "[frozen_graph][iterator]") {
+	auto const g = sample_graph();
+	auto const fg = gdwg::frozen_graph<std::string, int>(g);
+	using iterator = gdwg::frozen_graph<std::string, int>::iterator;
+	STATIC_REQUIRE(std::random_access_iterator<iterator>);
+
+	SECTION("Jumps land on the same edge as stepping") {
+		auto const first = fg.begin();
+		auto stepped = first;
+		for (auto n = std::ptrdiff_t{0}; n != fg.end() - first; ++n, ++stepped) {
+			auto const jumped = first + n;
+			REQUIRE(jumped == stepped);
+			REQUIRE((*jumped).from == (*stepped).from);
+			REQUIRE((*jumped).to == (*stepped).to);
+			REQUIRE(first[n].weight == (*stepped).weight);
+			REQUIRE(fg.end() - (fg.end() - jumped) == jumped);
+		}
+		REQUIRE(first + (fg.end() - first) == fg.end());
+	}
+
+	SECTION("Jumps skip sources without edges") {
+		// B has no outgoing edges, so the edge after A's last one is C's first.
+		auto const it = fg.begin() + 4;
+		REQUIRE((*it).from == "C");
+		REQUIRE((*it).to == "A");
+		REQUIRE((*std::prev(it)).from == "A");
+	}
+
+	SECTION("Contiguous chunks cover every edge once") {
+		auto const size = fg.end() - fg.begin();
+		auto weights = std::vector<std::optional<int>>{};
+		for (auto chunk = std::ptrdiff_t{0}; chunk < 4; ++chunk) {
+			auto const first = fg.begin() + chunk * size / 4;
+			auto const last = fg.begin() + (chunk + 1) * size / 4;
+			REQUIRE(first <= last);
+			for (auto it = first; it != last; ++it) {
+				weights.push_back((*it).weight);
+			}
+		}
+		REQUIRE(weights == std::vector<std::optional<int>>{std::nullopt, 1, 3, 2, 5, std::nullopt});
+	}
+}
+
+TEST_CASE("frozen_graph answers queries like the graph", "[frozen_graph]") {
+	auto const g = sample_graph();
+	auto const fg = gdwg::frozen_graph<std::string, int>(g);
+
+	SECTION("is_connected") {
+		REQUIRE(fg.is_connected("A", "B"));
+		REQUIRE(fg.is_connected("C", "C"));
+		REQUIRE_FALSE(fg.is_connected("B", "A"));
+		REQUIRE_THROWS_WITH(fg.is_connected("A", "E"),
+		                    "Cannot call gdwg::frozen_graph<N, E>::is_connected if src or dst node don't exist in the "
+		                    "graph");
+	}
+
+	SECTION("find") {
+		REQUIRE((*fg.find("A", "B")).weight == std::nullopt);
+		REQUIRE((*fg.find("A", "B", 3)).weight == 3);
+		REQUIRE((*fg.find("C", "A", 5)).from == "C");
+		REQUIRE(fg.find("A", "B", 2) == fg.end());
+		REQUIRE(fg.find("C", "A") == fg.end());
+		REQUIRE(fg.find("A", "E") == fg.end());
+		REQUIRE(std::next(fg.find("A", "B", 3)) == fg.find("A", "C", 2));
+	}
+
+	SECTION("connections") {
+		REQUIRE(fg.connections("A") == g.connections("A"));
+		REQUIRE(fg.connections("D").empty());
+		REQUIRE_THROWS_WITH(fg.connections("E"),
+		                    "Cannot call gdwg::frozen_graph<N, E>::connections if src doesn't exist in the graph");
+	}
+
+	SECTION("edges") {
+		auto const edges = fg.edges("A", "B");
+		REQUIRE(edges.size() == 3);
+		REQUIRE(edges[0]->print_edge() == "A -> B | U");
+		REQUIRE(edges[1]->print_edge() == "A -> B | W | 1");
+		REQUIRE(edges[2]->print_edge() == "A -> B | W | 3");
+		REQUIRE(fg.edges("B", "A").empty());
+		REQUIRE_THROWS_WITH(fg.edges("E", "A"),
+		                    "Cannot call gdwg::frozen_graph<N, E>::edges if src or dst node don't exist in the graph");
+	}
+}
+
+TEST_CASE("frozen_graph does not observe later changes to the graph", "[frozen_graph]") {
+	auto g = sample_graph();
+	auto const fg = gdwg::frozen_graph<std::string, int>(g);
+
+	g.erase_node("A");
+
+	REQUIRE(fg.is_node("A"));
+	REQUIRE(fg.is_connected("A", "B"));
+}
+
+TEST_CASE("frozen_graph copies share one snapshot", "[frozen_graph]") {
+	auto g = sample_graph();
+	auto fg = gdwg::frozen_graph<std::string, int>(g);
+
+	SECTION("Copies see the same edges") {
+		auto const copy = fg;
+		REQUIRE((*copy.find("A", "C", 2)).weight == 2);
+		REQUIRE(copy.nodes() == fg.nodes());
+		REQUIRE(copy.find("C", "A", 5) == fg.find("C", "A", 5));
+	}
+
+	SECTION("Iterators stay valid while any copy is alive") {
+		auto it = fg.find("C", "A", 5);
+		auto const copy = fg;
+		fg = gdwg::frozen_graph<std::string, int>();
+		REQUIRE(fg.empty());
+		REQUIRE((*it).from == "C");
+		REQUIRE(std::next(it) == std::prev(copy.end()));
+	}
+
+	SECTION("A new snapshot is needed to see later changes") {
+		auto const before = fg;
+		g.insert_edge("D", "A", 4);
+		fg = gdwg::frozen_graph<std::string, int>(g);
+		REQUIRE(fg.is_connected("D", "A"));
+		REQUIRE_FALSE(before.is_connected("D", "A"));
+	}
+}
@@ -0,0 +1,1100 @@
+// Benchmarks for every public operation of gdwg::graph, built on Google Benchmark.
+//
+// Each operation is measured for int and std::string nodes, for a sparse and a dense edge profile, and for graphs of
+// 1e3 to 1e7 edges (1e6 for std::string nodes). Benchmarks are registered size by size, so only one input graph is
+// alive at a time. Benchmark names are operation/node type/profile/edges. Useful flags:
+//   --benchmark_filter='^find/int/sparse/'     run a subset
+//   --benchmark_out=FILE --benchmark_out_format=json     keep a JSON report to compare releases
+// Every benchmark also reports the heap allocations made per iteration as allocs_per_op.
+#include "gdwg_binary.h"
+#include "gdwg_frozen_graph.h"
+#include "gdwg_graph.h"
+#include "gdwg_mapped_graph.h"
+#include "gdwg_persistent_graph.h"
+#include "gdwg_text.h"
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+	// Number of global operator new calls made so far, and heap bytes currently held through it. Atomic, since some
+	// operations allocate on several threads.
+	auto allocations = std::atomic<std::size_t>{0};
+	auto live_bytes = std::atomic<std::size_t>{0};
+	// Allocations made while a benchmark had its timer paused.
+	auto untimed_allocations = std::size_t{0};
+
+	enum class profile { sparse, dense };
+
+	auto profile_name(profile p) -> std::string {
+		return p == profile::sparse ? "sparse" : "dense";
+	}
+
+	// Sparse graphs have 8 outgoing edges per node on average; dense graphs connect a tenth of all ordered node pairs.
+	auto num_nodes(profile p, std::size_t num_edges) -> std::size_t {
+		if (p == profile::sparse) {
+			return num_edges / 8;
+		}
+		return static_cast<std::size_t>(std::sqrt(10.0 * static_cast<double>(num_edges)));
+	}
+
+	template<typename N>
+	auto type_name() -> std::string;
+
+	template<>
+	auto type_name<int>() -> std::string {
+		return "int";
+	}
+
+	template<>
+	auto type_name<std::string>() -> std::string {
+		return "string";
+	}
+
+	template<typename N>
+	auto node_value(std::size_t n) -> N;
+
+	template<>
+	auto node_value<int>(std::size_t n) -> int {
+		return static_cast<int>(n);
+	}
+
+	template<>
+	auto node_value<std::string>(std::size_t n) -> std::string {
+		auto name = std::to_string(n);
+		return "node-" + std::string(12 - name.size(), '0') + name;
+	}
+
+	// An edge between two nodes, given by their index in input::nodes.
+	struct edge_spec {
+		std::size_t src;
+		std::size_t dst;
+		int weight;
+	};
+
+	auto random_edges(std::size_t num_nodes, std::size_t num_edges, unsigned seed) -> std::vector<edge_spec> {
+		auto rng = std::mt19937{seed};
+		auto node = std::uniform_int_distribution<std::size_t>{0, num_nodes - 1};
+		auto weight = std::uniform_int_distribution<int>{0, 1000};
+		auto result = std::vector<edge_spec>{};
+		result.reserve(num_edges);
+		for (auto i = std::size_t{0}; i < num_edges; ++i) {
+			result.push_back({node(rng), node(rng), weight(rng)});
+		}
+		return result;
+	}
+
+	// Query operations cycle through this many queries.
+	constexpr auto num_queries = std::size_t{1024};
+
+	// The graph every benchmark of one (node type, profile, size) starts from, and the data it was built from.
+	template<typename N>
+	struct input {
+		input(profile p, std::size_t num_edges)
+		: edges(random_edges(num_nodes(p, num_edges), num_edges, 1)) {
+			auto const size = num_nodes(p, num_edges);
+			nodes.reserve(size);
+			for (auto n = std::size_t{0}; n < size; ++n) {
+				nodes.push_back(node_value<N>(n));
+			}
+			std::shuffle(nodes.begin(), nodes.end(), std::mt19937{2});
+
+			batch.reserve(edges.size());
+			for (auto const& e : edges) {
+				batch.emplace_back(nodes[e.src], nodes[e.dst], e.weight);
+			}
+			graph = gdwg::graph<N, int>(nodes.begin(), nodes.end());
+			graph.insert_edges(batch.begin(), batch.end());
+
+			// Half of the queries name an existing edge, the other half a random one that most likely does not exist.
+			auto const existing = random_edges(edges.size(), num_queries / 2, 3);
+			auto const random = random_edges(nodes.size(), num_queries / 2, 4);
+			for (auto i = std::size_t{0}; i < num_queries / 2; ++i) {
+				queries.push_back(edges[existing[i].src]);
+				queries.push_back(random[i]);
+			}
+		}
+
+		std::vector<N> nodes;
+		std::vector<edge_spec> edges;
+		std::vector<std::tuple<N, N, std::optional<int>>> batch;
+		std::vector<edge_spec> queries;
+		gdwg::graph<N, int> graph;
+	};
+
+	// Only the most recently used input is kept, so graphs of different sizes are never alive together.
+	auto cached_key = std::string{};
+	auto cached_input = std::shared_ptr<void>{};
+
+	template<typename N>
+	auto get_input(profile p, std::size_t num_edges) -> input<N> const& {
+		auto const key = type_name<N>() + "/" + profile_name(p) + "/" + std::to_string(num_edges);
+		if (key != cached_key) {
+			cached_input.reset();
+			cached_input = std::make_shared<input<N>>(p, num_edges);
+			cached_key = key;
+		}
+		return *static_cast<input<N> const*>(cached_input.get());
+	}
+
+	// Runs fn with the timer paused, leaving its allocations out of allocs_per_op.
+	template<typename F>
+	auto untimed(benchmark::State& state, F fn) -> void {
+		state.PauseTiming();
+		auto const before = allocations.load();
+		fn();
+		untimed_allocations += allocations - before;
+		state.ResumeTiming();
+	}
+
+	// Adds allocs_per_op, and items_per_second when each iteration handles `items` items.
+	auto finish(benchmark::State& state, std::size_t allocations_before, std::size_t items = 1) -> void {
+		auto const timed_allocations = allocations - allocations_before - untimed_allocations;
+		state.counters["allocs_per_op"] =
+		    benchmark::Counter(static_cast<double>(timed_allocations), benchmark::Counter::kAvgIterations);
+		state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(items));
+	}
+
+	auto start() -> std::size_t {
+		untimed_allocations = 0;
+		return allocations;
+	}
+
+	// Construction, copy and move
+
+	template<typename N>
+	auto bm_construct_nodes(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::graph<N, int>(in.nodes.begin(), in.nodes.end());
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.nodes.size());
+	}
+
+	// Builds the whole graph one insert_edge() call at a time, and reports the heap bytes it holds per edge.
+	template<typename N>
+	auto bm_build_insert_edge(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		auto bytes_per_edge = 0.0;
+		for (auto _ : state) {
+			auto g = gdwg::graph<N, int>(in.nodes.begin(), in.nodes.end());
+			auto const node_bytes = live_bytes.load();
+			for (auto const& [src, dst, weight] : in.batch) {
+				g.insert_edge(src, dst, weight);
+			}
+			bytes_per_edge = static_cast<double>(live_bytes - node_bytes) / static_cast<double>(in.batch.size());
+		}
+		finish(state, before, in.batch.size());
+		state.counters["bytes_per_edge"] = bytes_per_edge;
+	}
+
+	// Builds one run of as many edges as the graph has, all between the same two nodes, with the weights in random
+	// order. Every insert_edge() first looks up its weight in the run.
+	template<typename N>
+	auto bm_build_weight_run(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto weights = std::vector<int>(num_edges);
+		std::iota(weights.begin(), weights.end(), 0);
+		std::shuffle(weights.begin(), weights.end(), std::mt19937{7});
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::graph<N, int>{in.nodes[0], in.nodes[1]};
+			for (auto const weight : weights) {
+				g.insert_edge(in.nodes[0], in.nodes[1], weight);
+			}
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, weights.size());
+	}
+
+	template<typename N>
+	auto bm_build_insert_edges(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::graph<N, int>(in.nodes.begin(), in.nodes.end());
+			g.insert_edges(in.batch.begin(), in.batch.end());
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.batch.size());
+	}
+
+	template<typename N>
+	auto bm_copy_construct(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = in.graph;
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.edges.size());
+	}
+
+	// Takes a frozen_graph snapshot of the graph.
+	template<typename N>
+	auto bm_snapshot(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			auto snapshot = gdwg::frozen_graph<N, int>(in.graph);
+			benchmark::DoNotOptimize(snapshot);
+		}
+		finish(state, before, in.edges.size());
+	}
+
+	// Hands an existing snapshot to another reader.
+	template<typename N>
+	auto bm_snapshot_copy(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const snapshot = gdwg::frozen_graph<N, int>(in.graph);
+		auto const before = start();
+		for (auto _ : state) {
+			auto copy = snapshot;
+			benchmark::DoNotOptimize(copy);
+		}
+		finish(state, before);
+	}
+
+	// Takes an O(1) snapshot of a live graph, then changes the live graph while the snapshot is held, which copies
+	// only the blocks the change touches.
+	template<typename N>
+	auto bm_graph_snapshot(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto live = in.graph;
+		auto rng = std::mt19937{5};
+		auto pick_node = std::uniform_int_distribution<std::size_t>{0, in.nodes.size() - 1};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const snapshot = live.snapshot();
+			live.insert_edge(in.nodes[pick_node(rng)], in.nodes[pick_node(rng)], 0);
+			benchmark::DoNotOptimize(snapshot);
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_copy_assign(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto const before = start();
+		for (auto _ : state) {
+			g = in.graph;
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.edges.size());
+	}
+
+	// Each iteration moves the graph out and back again.
+	template<typename N>
+	auto bm_move(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto g = get_input<N>(p, num_edges).graph;
+		auto const before = start();
+		for (auto _ : state) {
+			auto moved = std::move(g);
+			g = std::move(moved);
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before);
+	}
+
+	// Modifiers
+
+	template<typename N>
+	auto bm_insert_node(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto next = in.nodes.size();
+		auto const before = start();
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(g.insert_node(node_value<N>(next++)));
+		}
+		finish(state, before);
+	}
+
+	// Inserts edges that are almost always new.
+	template<typename N>
+	auto bm_insert_edge(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto const fresh = random_edges(in.nodes.size(), num_queries, 5);
+		auto weight = 1001;
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& e = fresh[i++ % fresh.size()];
+			benchmark::DoNotOptimize(g.insert_edge(in.nodes[e.src], in.nodes[e.dst], weight++));
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_insert_edge_duplicate(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& [src, dst, weight] = in.batch[i++ % in.batch.size()];
+			benchmark::DoNotOptimize(g.insert_edge(src, dst, weight));
+		}
+		finish(state, before);
+	}
+
+	// Renames random nodes to values that are not in the graph.
+	template<typename N>
+	auto bm_replace_node(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto names = in.nodes;
+		auto const picks = random_edges(names.size(), num_queries, 6);
+		auto next = names.size();
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto& name = names[picks[i++ % picks.size()].src];
+			auto value = node_value<N>(next++);
+			benchmark::DoNotOptimize(g.replace_node(name, value));
+			name = std::move(value);
+		}
+		finish(state, before);
+	}
+
+	// Merges disjoint pairs of nodes, starting over from a fresh copy once every pair has been merged.
+	template<typename N>
+	auto bm_merge_replace_node(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			if (i + 1 >= in.nodes.size()) {
+				untimed(state, [&] { g = in.graph; });
+				i = 0;
+			}
+			g.merge_replace_node(in.nodes[i], in.nodes[i + 1]);
+			i += 2;
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_erase_node(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			if (i == in.nodes.size()) {
+				untimed(state, [&] { g = in.graph; });
+				i = 0;
+			}
+			benchmark::DoNotOptimize(g.erase_node(in.nodes[i++]));
+		}
+		finish(state, before);
+	}
+
+	// Erases a hub: a node added to the graph with a fifth of all the edges incident to it, half of them outgoing and
+	// half incoming. erase_node() visits only the node's own edges, so this costs time in its degree.
+	template<typename N>
+	auto bm_erase_node_hub(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const hub = node_value<N>(in.nodes.size());
+		auto const hub_degree = num_edges / 4;
+		auto with_hub = in.graph;
+		with_hub.insert_node(hub);
+		for (auto n = std::size_t{0}; n < hub_degree; n += 2) {
+			auto const& other = in.nodes[n % in.nodes.size()];
+			with_hub.insert_edge(hub, other, static_cast<int>(n));
+			with_hub.insert_edge(other, hub, static_cast<int>(n));
+		}
+
+		auto g = gdwg::graph<N, int>{};
+		auto const before = start();
+		for (auto _ : state) {
+			untimed(state, [&] { g = with_hub; });
+			benchmark::DoNotOptimize(g.erase_node(hub));
+		}
+		finish(state, before, hub_degree);
+	}
+
+	template<typename N>
+	auto bm_erase_edge(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			if (i == in.batch.size()) {
+				untimed(state, [&] { g = in.graph; });
+				i = 0;
+			}
+			auto const& [src, dst, weight] = in.batch[i++];
+			benchmark::DoNotOptimize(g.erase_edge(src, dst, weight));
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_erase_edge_iterator(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto const before = start();
+		for (auto _ : state) {
+			if (g.begin() == g.end()) {
+				untimed(state, [&] { g = in.graph; });
+			}
+			benchmark::DoNotOptimize(g.erase_edge(g.begin()));
+		}
+		finish(state, before);
+	}
+
+	// Erases ranges of 16 edges from the front of the graph.
+	template<typename N>
+	auto bm_erase_edge_range(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		constexpr auto range = 16;
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto const size = std::distance(g.begin(), g.end());
+		auto remaining = size;
+		auto const before = start();
+		for (auto _ : state) {
+			if (remaining < range) {
+				untimed(state, [&] { g = in.graph; });
+				remaining = size;
+			}
+			benchmark::DoNotOptimize(g.erase_edge(g.begin(), std::next(g.begin(), range)));
+			remaining -= range;
+		}
+		finish(state, before, range);
+	}
+
+	template<typename N>
+	auto bm_clear(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto g = in.graph;
+		auto const before = start();
+		for (auto _ : state) {
+			untimed(state, [&] { g = in.graph; });
+			g.clear();
+		}
+		finish(state, before, in.edges.size());
+	}
+
+	// Accessors
+
+	template<typename N>
+	auto bm_is_node(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const missing = node_value<N>(in.nodes.size());
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& value = i % 2 == 0 ? in.nodes[in.queries[i % num_queries].src] : missing;
+			++i;
+			benchmark::DoNotOptimize(in.graph.is_node(value));
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_empty(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(in.graph.empty());
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_is_connected(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			benchmark::DoNotOptimize(in.graph.is_connected(in.nodes[q.src], in.nodes[q.dst]));
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_find(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			benchmark::DoNotOptimize(in.graph.find(in.nodes[q.src], in.nodes[q.dst], q.weight));
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_edges(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			benchmark::DoNotOptimize(in.graph.edges(in.nodes[q.src], in.nodes[q.dst]));
+		}
+		finish(state, before);
+	}
+
+	// Reads every weight between the queried nodes, the work edges() makes callers allocate for.
+	template<typename N>
+	auto bm_edges_view(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			auto sum = 0;
+			for (auto const& edge : in.graph.edges_view(in.nodes[q.src], in.nodes[q.dst])) {
+				sum += edge.weight != nullptr ? *edge.weight : 0;
+			}
+			benchmark::DoNotOptimize(sum);
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_connections(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			benchmark::DoNotOptimize(in.graph.connections(in.nodes[q.src]));
+		}
+		finish(state, before);
+	}
+
+	// Walks the distinct neighbours of the queried node.
+	template<typename N>
+	auto bm_connections_view(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			for (auto const& to : in.graph.connections_view(in.nodes[q.src])) {
+				benchmark::DoNotOptimize(to);
+			}
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_out_degree(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			benchmark::DoNotOptimize(in.graph.out_degree(in.nodes[q.src]));
+		}
+		finish(state, before);
+	}
+
+	template<typename N>
+	auto bm_nodes(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(in.graph.nodes());
+		}
+		finish(state, before, in.nodes.size());
+	}
+
+	// Iterator access
+
+	template<typename G>
+	auto iterate(benchmark::State& state, G const& g, std::size_t num_edges) -> void {
+		auto const before = start();
+		for (auto _ : state) {
+			for (auto const& [from, to, weight] : g) {
+				benchmark::DoNotOptimize(from);
+				benchmark::DoNotOptimize(to);
+				benchmark::DoNotOptimize(weight);
+			}
+		}
+		finish(state, before, num_edges);
+	}
+
+	template<typename N>
+	auto bm_iterate(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		iterate(state, in.graph, in.edges.size());
+	}
+
+	// Same walk as bm_iterate, through references instead of copies.
+	template<typename N>
+	auto bm_iterate_refs(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			for (auto const& [from, to, weight] : in.graph.edge_refs()) {
+				benchmark::DoNotOptimize(from);
+				benchmark::DoNotOptimize(to);
+				benchmark::DoNotOptimize(weight);
+			}
+		}
+		finish(state, before, in.edges.size());
+	}
+
+	template<typename N>
+	auto bm_iterate_frozen(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		iterate(state, gdwg::frozen_graph<N, int>(in.graph), in.edges.size());
+	}
+
+	// Sums every edge weight with one thread per contiguous chunk of a frozen graph's edges.
+	template<typename N, int Threads>
+	auto bm_sum_weights(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const frozen = gdwg::frozen_graph<N, int>(in.graph);
+		auto const size = frozen.end() - frozen.begin();
+		auto const before = start();
+		for (auto _ : state) {
+			auto sums = std::vector<long>(Threads, 0);
+			auto workers = std::vector<std::thread>{};
+			for (auto t = 0; t < Threads; ++t) {
+				workers.emplace_back([&frozen, &sums, size, t] {
+					auto const last = frozen.begin() + (t + 1) * size / Threads;
+					auto sum = 0L;
+					for (auto it = frozen.begin() + t * size / Threads; it != last; ++it) {
+						sum += (*it).weight.value_or(0);
+					}
+					sums[static_cast<std::size_t>(t)] = sum;
+				});
+			}
+			for (auto& worker : workers) {
+				worker.join();
+			}
+			benchmark::DoNotOptimize(std::accumulate(sums.begin(), sums.end(), 0L));
+		}
+		finish(state, before, in.edges.size());
+	}
+
+	// Persistent versions
+
+	// Keeps 1000 versions of the graph, each made from the one before by changing 0.1% of the edges, half erased and
+	// half inserted. Reports the heap bytes each version adds, next to what a full graph copy holds.
+	template<typename N>
+	auto bm_persistent_versions(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		constexpr auto num_versions = std::size_t{1000};
+		auto const& in = get_input<N>(p, num_edges);
+		auto const churn = std::max(num_edges / 1000, std::size_t{2});
+
+		auto const copy_before = live_bytes.load();
+		auto const copy = std::make_unique<gdwg::graph<N, int>>(in.graph);
+		auto const copy_bytes = live_bytes - copy_before;
+		auto const base = gdwg::persistent_graph<N, int>(in.graph);
+
+		auto rng = std::mt19937{5};
+		auto pick_edge = std::uniform_int_distribution<std::size_t>{0, in.edges.size() - 1};
+		auto pick_node = std::uniform_int_distribution<std::size_t>{0, in.nodes.size() - 1};
+		auto bytes_per_version = 0.0;
+		auto const before = start();
+		for (auto _ : state) {
+			auto versions = std::vector<gdwg::persistent_graph<N, int>>{};
+			versions.reserve(num_versions);
+			auto const bytes_before = live_bytes.load();
+			auto version = base;
+			for (auto v = std::size_t{0}; v < num_versions; ++v) {
+				for (auto c = std::size_t{0}; c < churn / 2; ++c) {
+					auto const& e = in.edges[pick_edge(rng)];
+					version = version.erase_edge(in.nodes[e.src], in.nodes[e.dst], e.weight);
+					version = version.insert_edge(in.nodes[pick_node(rng)], in.nodes[pick_node(rng)], e.weight);
+				}
+				versions.push_back(version);
+			}
+			bytes_per_version = static_cast<double>(live_bytes - bytes_before) / static_cast<double>(num_versions);
+		}
+		finish(state, before, num_versions);
+		state.counters["bytes_per_version"] = bytes_per_version;
+		state.counters["graph_copy_bytes"] = static_cast<double>(copy_bytes);
+	}
+
+	// Takes an O(1) snapshot of a live persistent_graph, then changes the live version, which copies only the paths
+	// the change touches. Together they are the persistent_graph counterpart of graph_snapshot.
+	template<typename N>
+	auto bm_persistent_snapshot(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto live = gdwg::persistent_graph<N, int>(in.graph);
+		auto rng = std::mt19937{5};
+		auto pick_node = std::uniform_int_distribution<std::size_t>{0, in.nodes.size() - 1};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const snapshot = live;
+			live = live.insert_edge(in.nodes[pick_node(rng)], in.nodes[pick_node(rng)], 0);
+			benchmark::DoNotOptimize(snapshot);
+		}
+		finish(state, before);
+	}
+
+	// Comparisons and extractor
+
+	// Compares against an equal copy, the worst case.
+	template<typename N>
+	auto bm_equal(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const copy = in.graph;
+		auto const before = start();
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(in.graph == copy);
+		}
+		finish(state, before, in.edges.size());
+	}
+
+	template<typename N>
+	auto bm_hash(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(std::hash<gdwg::graph<N, int>>{}(in.graph));
+		}
+		finish(state, before);
+	}
+
+	// Dumps the graph as text, and reports the output rate as bytes_per_second.
+	template<typename N>
+	auto bm_output(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto bytes = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto os = std::ostringstream{};
+			os << in.graph;
+			bytes = os.view().size();
+			benchmark::DoNotOptimize(os);
+		}
+		finish(state, before, in.edges.size());
+		state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+	}
+
+	// Text input is read from one stream that is rewound before every iteration, so the text is never copied.
+	auto rewind(std::istringstream& in) -> std::istringstream& {
+		in.clear();
+		in.seekg(0);
+		return in;
+	}
+
+	auto report_bytes(benchmark::State& state, std::size_t bytes) -> void {
+		state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+	}
+
+	// Reads the graph back from the text operator<< wrote.
+	template<typename N>
+	auto bm_input(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto out = std::ostringstream{};
+		out << in.graph;
+		auto text = std::istringstream(out.str());
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::graph<N, int>{};
+			rewind(text) >> g;
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.edges.size());
+		report_bytes(state, out.view().size());
+	}
+
+	// Only parses the text operator<< wrote, without building the graph.
+	template<typename N>
+	auto bm_parse_input(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto out = std::ostringstream{};
+		out << in.graph;
+		auto text = std::istringstream(out.str());
+		auto const before = start();
+		for (auto _ : state) {
+			auto builder = gdwg::text::graph_builder<N, int>{};
+			benchmark::DoNotOptimize(gdwg::text::read_graph(*rewind(text).rdbuf(), builder));
+			benchmark::DoNotOptimize(builder);
+		}
+		finish(state, before, in.edges.size());
+		report_bytes(state, out.view().size());
+	}
+
+	// The input edges as an edge list, one "src dst weight" line each.
+	template<typename N>
+	auto edge_list(input<N> const& in) -> std::string {
+		auto out = std::ostringstream{};
+		for (auto const& [src, dst, weight] : in.batch) {
+			out << src << ' ' << dst << ' ' << *weight << '\n';
+		}
+		return out.str();
+	}
+
+	template<typename N>
+	auto bm_read_edge_list(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto text = std::istringstream(edge_list(in));
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::read_edge_list<N, int>(rewind(text));
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.edges.size());
+		report_bytes(state, text.view().size());
+	}
+
+	// Only parses an edge list, without building the graph.
+	template<typename N>
+	auto bm_parse_edge_list(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto text = std::istringstream(edge_list(in));
+		auto const before = start();
+		for (auto _ : state) {
+			auto builder = gdwg::text::graph_builder<N, int>{};
+			benchmark::DoNotOptimize(gdwg::text::read_edge_list(*rewind(text).rdbuf(), builder));
+			benchmark::DoNotOptimize(builder);
+		}
+		finish(state, before, in.edges.size());
+		report_bytes(state, text.view().size());
+	}
+
+	// Reads an edge list file on the given number of threads. Building the graph from the merged parts stays on one
+	// thread, so it bounds the speedup.
+	template<typename N, unsigned Threads>
+	auto bm_load_edge_list(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const path = std::filesystem::temp_directory_path() / "gdwg_graph_bench.txt";
+		std::ofstream(path, std::ios::binary) << edge_list(in);
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::read_edge_list<N, int>(path, Threads);
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.edges.size());
+		report_bytes(state, std::filesystem::file_size(path));
+		std::filesystem::remove(path);
+	}
+
+	auto binary_path() -> std::filesystem::path {
+		return std::filesystem::temp_directory_path() / "gdwg_graph_bench.bin";
+	}
+
+	// Writes the graph in the binary format, and reports the file size as bytes_per_second.
+	template<typename N>
+	auto bm_save_binary(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const before = start();
+		for (auto _ : state) {
+			gdwg::save_binary(in.graph, binary_path());
+		}
+		finish(state, before, in.edges.size());
+		auto const bytes = std::filesystem::file_size(binary_path());
+		state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+		std::filesystem::remove(binary_path());
+	}
+
+	// Rebuilds the graph from a file in the binary format.
+	template<typename N>
+	auto bm_load_binary(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		gdwg::save_binary(in.graph, binary_path());
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::load_binary<N, int>(binary_path());
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before, in.edges.size());
+		auto const bytes = std::filesystem::file_size(binary_path());
+		state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(bytes));
+		std::filesystem::remove(binary_path());
+	}
+
+	// Opens a saved graph for queries, which maps the file instead of reading it.
+	template<typename N>
+	auto bm_open_mapped(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		auto const path = binary_path();
+		gdwg::save_binary(in.graph, path);
+		auto const before = start();
+		for (auto _ : state) {
+			auto g = gdwg::mapped_graph<N, int>(path);
+			benchmark::DoNotOptimize(g);
+		}
+		finish(state, before);
+		std::filesystem::remove(binary_path());
+	}
+
+	template<typename N>
+	auto bm_find_mapped(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		gdwg::save_binary(in.graph, binary_path());
+		auto const g = gdwg::mapped_graph<N, int>(binary_path());
+		auto i = std::size_t{0};
+		auto const before = start();
+		for (auto _ : state) {
+			auto const& q = in.queries[i++ % num_queries];
+			benchmark::DoNotOptimize(g.find(in.nodes[q.src], in.nodes[q.dst], q.weight));
+		}
+		finish(state, before);
+		std::filesystem::remove(binary_path());
+	}
+
+	template<typename N>
+	auto bm_iterate_mapped(benchmark::State& state, profile p, std::size_t num_edges) -> void {
+		auto const& in = get_input<N>(p, num_edges);
+		gdwg::save_binary(in.graph, binary_path());
+		iterate(state, gdwg::mapped_graph<N, int>(binary_path()), in.edges.size());
+		std::filesystem::remove(binary_path());
+	}
+
+	struct operation {
+		char const* name;
+		void (*fn)(benchmark::State&, profile, std::size_t);
+		// Largest graph the operation is run on. Operations that are quadratic today stop early.
+		std::size_t max_edges;
+		benchmark::TimeUnit unit;
+		// Operations that spread work over threads are timed by the wall clock instead of the main thread's CPU time.
+		bool real_time = false;
+	};
+
+	// Largest graph benchmarked, in edges.
+	constexpr auto largest_size = std::size_t{10'000'000};
+
+	template<typename N>
+	auto operations() -> std::vector<operation> {
+		return {
+		    {"construct_nodes", bm_construct_nodes<N>, largest_size, benchmark::kMillisecond},
+		    {"build_insert_edge", bm_build_insert_edge<N>, largest_size, benchmark::kMillisecond},
+		    {"build_insert_edges", bm_build_insert_edges<N>, largest_size, benchmark::kMillisecond},
+		    {"build_weight_run", bm_build_weight_run<N>, 1'000'000, benchmark::kMillisecond},
+		    {"copy_construct", bm_copy_construct<N>, largest_size, benchmark::kMillisecond},
+		    {"copy_assign", bm_copy_assign<N>, largest_size, benchmark::kMillisecond},
+		    {"snapshot", bm_snapshot<N>, largest_size, benchmark::kMillisecond},
+		    {"snapshot_copy", bm_snapshot_copy<N>, largest_size, benchmark::kNanosecond},
+		    {"graph_snapshot", bm_graph_snapshot<N>, largest_size, benchmark::kNanosecond},
+		    {"move", bm_move<N>, largest_size, benchmark::kNanosecond},
+		    {"insert_node", bm_insert_node<N>, largest_size, benchmark::kNanosecond},
+		    {"insert_edge", bm_insert_edge<N>, largest_size, benchmark::kNanosecond},
+		    {"insert_edge_duplicate", bm_insert_edge_duplicate<N>, largest_size, benchmark::kNanosecond},
+		    {"replace_node", bm_replace_node<N>, largest_size, benchmark::kMicrosecond},
+		    {"merge_replace_node", bm_merge_replace_node<N>, largest_size, benchmark::kMicrosecond},
+		    {"erase_node", bm_erase_node<N>, largest_size, benchmark::kMicrosecond},
+		    {"erase_node_hub", bm_erase_node_hub<N>, 1'000'000, benchmark::kMillisecond},
+		    {"erase_edge", bm_erase_edge<N>, largest_size, benchmark::kNanosecond},
+		    {"erase_edge_iterator", bm_erase_edge_iterator<N>, largest_size, benchmark::kNanosecond},
+		    {"erase_edge_range", bm_erase_edge_range<N>, largest_size, benchmark::kNanosecond},
+		    {"clear", bm_clear<N>, largest_size, benchmark::kMillisecond},
+		    {"is_node", bm_is_node<N>, largest_size, benchmark::kNanosecond},
+		    {"empty", bm_empty<N>, largest_size, benchmark::kNanosecond},
+		    {"is_connected", bm_is_connected<N>, largest_size, benchmark::kNanosecond},
+		    {"find", bm_find<N>, largest_size, benchmark::kNanosecond},
+		    {"edges", bm_edges<N>, largest_size, benchmark::kNanosecond},
+		    {"edges_view", bm_edges_view<N>, largest_size, benchmark::kNanosecond},
+		    {"connections", bm_connections<N>, largest_size, benchmark::kNanosecond},
+		    {"connections_view", bm_connections_view<N>, largest_size, benchmark::kNanosecond},
+		    {"out_degree", bm_out_degree<N>, largest_size, benchmark::kNanosecond},
+		    {"nodes", bm_nodes<N>, largest_size, benchmark::kMillisecond},
+		    {"iterate", bm_iterate<N>, largest_size, benchmark::kMillisecond},
+		    {"iterate_refs", bm_iterate_refs<N>, largest_size, benchmark::kMillisecond},
+		    {"iterate_frozen", bm_iterate_frozen<N>, largest_size, benchmark::kMillisecond},
+		    {"sum_weights_1_thread", bm_sum_weights<N, 1>, largest_size, benchmark::kMillisecond, true},
+		    {"sum_weights_4_threads", bm_sum_weights<N, 4>, largest_size, benchmark::kMillisecond, true},
+		    {"sum_weights_16_threads", bm_sum_weights<N, 16>, largest_size, benchmark::kMillisecond, true},
+		    {"persistent_versions", bm_persistent_versions<N>, 100'000, benchmark::kMillisecond},
+		    {"persistent_snapshot", bm_persistent_snapshot<N>, 1'000'000, benchmark::kNanosecond},
+		    {"equal", bm_equal<N>, largest_size, benchmark::kMillisecond},
+		    {"hash", bm_hash<N>, largest_size, benchmark::kNanosecond},
+		    {"output", bm_output<N>, largest_size, benchmark::kMillisecond},
+		    {"input", bm_input<N>, largest_size, benchmark::kMillisecond},
+		    {"parse_input", bm_parse_input<N>, largest_size, benchmark::kMillisecond},
+		    {"read_edge_list", bm_read_edge_list<N>, largest_size, benchmark::kMillisecond},
+		    {"parse_edge_list", bm_parse_edge_list<N>, largest_size, benchmark::kMillisecond},
+		    {"load_edge_list_1_thread", bm_load_edge_list<N, 1>, largest_size, benchmark::kMillisecond, true},
+		    {"load_edge_list_2_threads", bm_load_edge_list<N, 2>, largest_size, benchmark::kMillisecond, true},
+		    {"load_edge_list_4_threads", bm_load_edge_list<N, 4>, largest_size, benchmark::kMillisecond, true},
+		    {"load_edge_list_8_threads", bm_load_edge_list<N, 8>, largest_size, benchmark::kMillisecond, true},
+		    {"load_edge_list_16_threads", bm_load_edge_list<N, 16>, largest_size, benchmark::kMillisecond, true},
+		    {"load_edge_list_32_threads", bm_load_edge_list<N, 32>, largest_size, benchmark::kMillisecond, true},
+		    {"save_binary", bm_save_binary<N>, largest_size, benchmark::kMillisecond},
+		    {"load_binary", bm_load_binary<N>, largest_size, benchmark::kMillisecond},
+		    {"open_mapped", bm_open_mapped<N>, largest_size, benchmark::kMicrosecond},
+		    {"find_mapped", bm_find_mapped<N>, largest_size, benchmark::kNanosecond},
+		    {"iterate_mapped", bm_iterate_mapped<N>, largest_size, benchmark::kMillisecond},
+		};
+	}
+
+	template<typename N>
+	auto register_size(std::size_t num_edges) -> void {
+		for (auto const p : {profile::sparse, profile::dense}) {
+			for (auto const& op : operations<N>()) {
+				if (num_edges > op.max_edges) {
+					continue;
+				}
+				auto const name = std::string(op.name) + "/" + type_name<N>() + "/" + profile_name(p) + "/"
+				                  + std::to_string(num_edges);
+				auto* bench = benchmark::RegisterBenchmark(name.c_str(), op.fn, p, num_edges)->Unit(op.unit);
+				if (op.real_time) {
+					bench->UseRealTime();
+				}
+			}
+		}
+	}
+} // namespace
+
+auto operator new(std::size_t size) -> void* {
+	auto* p = std::malloc(size == 0 ? 1 : size);
+	if (p == nullptr) {
+		throw std::bad_alloc{};
+	}
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	live_bytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+	return p;
+}
+
+// Kept out of line: once inlined into std::allocator, GCC mistakes the free() for a mismatched deallocation.
+[[gnu::noinline]] auto operator delete(void* p) noexcept -> void {
+	live_bytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+	std::free(p);
+}
+
+auto operator delete(void* p, std::size_t) noexcept -> void {
+	operator delete(p);
+}
+
+auto main(int argc, char* argv[]) -> int {
+	for (auto num_edges = std::size_t{1'000}; num_edges <= largest_size; num_edges *= 10) {
+		register_size<int>(num_edges);
+		if (num_edges <= 1'000'000) {
+			register_size<std::string>(num_edges);
+		}
+	}
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+}
@@ -2,15 +2,39 @@
 #define GDWG_GRAPH_H
 
 #include <boost/functional/hash.hpp>
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <ranges>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace gdwg {
+	template<typename N, typename E>
+	class graph;
+
+	// Spreads a hash over every bit (the splitmix64 finaliser), so that sums of related hashes rarely collide and
+	// hashes of similar values look unrelated.
+	constexpr auto mix_hash(std::size_t seed) noexcept -> std::size_t {
+		auto x = static_cast<std::uint64_t>(seed);
+		x = (x ^ (x >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27U)) * 0x94d049bb133111ebULL;
+		return static_cast<std::size_t>(x ^ (x >> 31U));
+	}
+
 	template<typename N, typename E>
 	class edge {
 	 public:
@@ -72,31 +96,111 @@ namespace gdwg {
 	 public:
 		using edge = gdwg::edge<N, E>;
 
+		// An edge as stored in a graph: plain data, ordered without any virtual call. src and dst point at the
+		// graph's node objects, whose ids are src_id and dst_id.
+		struct edge_record {
+			N const* src;
+			N const* dst;
+			std::uint32_t src_id;
+			std::uint32_t dst_id;
+			std::optional<E> weight;
+		};
+
+		// Lookup key of an edge: (src, dst, weight), with a null weight for an unweighted edge.
+		using edge_key = std::tuple<N const&, N const&, E const*>;
+		// Lookup key matching every edge from src to dst.
+		struct run_key {
+			N const& src;
+			N const& dst;
+		};
+
 		struct edge_cmp {
-			bool operator()(const std::unique_ptr<edge>& lhs, const std::unique_ptr<edge>& rhs) const {
-				auto lhs_nodes = lhs->get_nodes();
-				auto rhs_nodes = rhs->get_nodes();
+			using is_transparent = void;
 
-				if (lhs_nodes.first != rhs_nodes.first) {
-					return lhs_nodes.first < rhs_nodes.first;
+			bool operator()(edge_key const& lhs, edge_key const& rhs) const {
+				auto const& [lhs_src, lhs_dst, lhs_weight] = lhs;
+				auto const& [rhs_src, rhs_dst, rhs_weight] = rhs;
+
+				// Edges stored in a graph share node objects, so equal nodes are usually the same object.
+				if (&lhs_src != &rhs_src and lhs_src != rhs_src) {
+					return lhs_src < rhs_src;
 				}
 
-				if (lhs_nodes.second != rhs_nodes.second) {
-					return lhs_nodes.second < rhs_nodes.second;
+				if (&lhs_dst != &rhs_dst and lhs_dst != rhs_dst) {
+					return lhs_dst < rhs_dst;
 				}
 
-				if (lhs->is_weighted() != rhs->is_weighted()) {
-					return not lhs->is_weighted();
+				// Unweighted edges precede weighted ones, and two unweighted edges between the same nodes are the
+				// same edge.
+				if (lhs_weight == nullptr or rhs_weight == nullptr) {
+					return lhs_weight == nullptr and rhs_weight != nullptr;
 				}
 
-				if (lhs->is_weighted() and rhs->is_weighted()) {
-					return lhs->get_weight() < rhs->get_weight();
+				return *lhs_weight < *rhs_weight;
+			}
+
+			bool operator()(edge_record const& lhs, edge_record const& rhs) const {
+				return (*this)(key_of(lhs), key_of(rhs));
+			}
+
+			bool operator()(edge_record const& lhs, edge_key const& rhs) const {
+				return (*this)(key_of(lhs), rhs);
+			}
+
+			bool operator()(edge_key const& lhs, edge_record const& rhs) const {
+				return (*this)(lhs, key_of(rhs));
+			}
+
+			bool operator()(edge_record const& lhs, run_key const& rhs) const {
+				if (lhs.src != &rhs.src and *lhs.src != rhs.src) {
+					return *lhs.src < rhs.src;
+				}
+				return lhs.dst != &rhs.dst and *lhs.dst < rhs.dst;
+			}
+
+			bool operator()(run_key const& lhs, edge_record const& rhs) const {
+				if (&lhs.src != rhs.src and lhs.src != *rhs.src) {
+					return lhs.src < *rhs.src;
 				}
+				return &lhs.dst != rhs.dst and lhs.dst < *rhs.dst;
+			}
+		};
+
+		using edge_set = std::set<edge_record, edge_cmp>;
+
+	 private:
+		// Dense id of a node in nodes_. Ids of erased nodes are reused by later insertions.
+		using node_id = std::uint32_t;
+		static constexpr auto no_node = std::numeric_limits<node_id>::max();
+		struct out_block;
+
+		// Index of a source node in sources_: its chunk, and its offset in the chunk.
+		struct source_position {
+			std::size_t chunk = 0;
+			std::size_t offset = 0;
+		};
 
-				return lhs < rhs;
+		// Where an iterator is: at an edge in the block of its source, or at the end when block is null. Edges are
+		// visited block after block in source order. The source's position in sources_ is kept so that the next
+		// block is found in O(1), and is searched for again if sources_ has changed since.
+		struct edge_cursor {
+			auto next() -> void;
+			auto prev() -> void;
+			auto operator==(edge_cursor const& other) const -> bool {
+				if (block == nullptr or other.block == nullptr) {
+					return block == other.block;
+				}
+				return &*it == &*other.it;
 			}
+
+			graph const* g = nullptr;
+			out_block const* block = nullptr;
+			typename edge_set::iterator it = {};
+			node_id src = 0;
+			source_position position = {};
 		};
 
+	 public:
 		class iterator {
 		 public:
 			using value_type = struct {
@@ -110,45 +214,158 @@ namespace gdwg {
 			using iterator_category = std::bidirectional_iterator_tag;
 
 			iterator() = default;
-			explicit iterator(typename std::set<std::unique_ptr<edge>, edge_cmp>::iterator it)
-			: it_(it) {}
 
 			// Iterator source
 			auto operator*() -> reference {
-				auto nodes = (*it_)->get_nodes();
-				return {nodes.first, nodes.second, (*it_)->get_weight()};
+				return {*cursor_.it->src, *cursor_.it->dst, cursor_.it->weight};
 			}
 
 			// Iterator traversal
 			auto operator++() -> iterator& {
-				++it_;
+				cursor_.next();
 				return *this;
 			}
 			auto operator++(int) -> iterator {
 				auto temp = *this;
-				++it_;
+				cursor_.next();
 				return temp;
 			}
 			auto operator--() -> iterator& {
-				--it_;
+				cursor_.prev();
 				return *this;
 			}
 			auto operator--(int) -> iterator {
 				auto temp = *this;
-				--it_;
+				cursor_.prev();
 				return temp;
 			}
 
 			// Iterator comparison
 			auto operator==(iterator const& other) const -> bool {
+				return cursor_ == other.cursor_;
+			}
+
+		 private:
+			explicit iterator(edge_cursor cursor)
+			: cursor_(cursor) {}
+
+			edge_cursor cursor_;
+			friend class graph<N, E>;
+		};
+
+		// A stored edge, seen through references into the graph instead of copies. It stays valid until the edge is
+		// erased or one of its nodes is replaced, or, once a snapshot shares it, until its source's edges change.
+		struct edge_ref {
+			N const& from;
+			N const& to;
+			// nullptr for an unweighted edge.
+			E const* weight;
+		};
+
+		class edge_ref_iterator {
+		 public:
+			using value_type = edge_ref;
+			using reference = edge_ref;
+			using pointer = void;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			edge_ref_iterator() = default;
+
+			// Iterator source
+			auto operator*() const -> reference {
+				auto const& e = *cursor_.it;
+				return {*e.src, *e.dst, e.weight ? &*e.weight : nullptr};
+			}
+
+			// Iterator traversal
+			auto operator++() -> edge_ref_iterator& {
+				cursor_.next();
+				return *this;
+			}
+			auto operator++(int) -> edge_ref_iterator {
+				auto temp = *this;
+				cursor_.next();
+				return temp;
+			}
+			auto operator--() -> edge_ref_iterator& {
+				cursor_.prev();
+				return *this;
+			}
+			auto operator--(int) -> edge_ref_iterator {
+				auto temp = *this;
+				cursor_.prev();
+				return temp;
+			}
+
+			// Iterator comparison
+			auto operator==(edge_ref_iterator const& other) const -> bool {
+				return cursor_ == other.cursor_;
+			}
+
+		 private:
+			explicit edge_ref_iterator(edge_cursor cursor)
+			: cursor_(cursor) {}
+
+			edge_cursor cursor_;
+			friend class graph<N, E>;
+		};
+
+		using edge_ref_range = std::ranges::subrange<edge_ref_iterator>;
+
+		// Iterates over the distinct destinations of one node's outgoing edges, in ascending order.
+		class connection_iterator {
+		 public:
+			using value_type = N;
+			using reference = N const&;
+			using pointer = N const*;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::forward_iterator_tag;
+
+			connection_iterator() = default;
+
+			// Iterator source
+			auto operator*() const -> reference {
+				return *it_->dst;
+			}
+			auto operator->() const -> pointer {
+				return it_->dst;
+			}
+
+			// Iterator traversal
+			auto operator++() -> connection_iterator& {
+				// Edges to the same destination are adjacent, so skipping them leaves each destination once.
+				auto const dst = it_->dst_id;
+				++it_;
+				while (it_ != last_ and it_->dst_id == dst) {
+					++it_;
+				}
+				return *this;
+			}
+			auto operator++(int) -> connection_iterator {
+				auto temp = *this;
+				++*this;
+				return temp;
+			}
+
+			// Iterator comparison
+			auto operator==(connection_iterator const& other) const -> bool {
 				return it_ == other.it_;
 			}
 
 		 private:
-			typename std::set<std::unique_ptr<edge>, edge_cmp>::iterator it_;
+			connection_iterator(typename edge_set::const_iterator it, typename edge_set::const_iterator last)
+			: it_(it)
+			, last_(last) {}
+
+			typename edge_set::const_iterator it_;
+			// End of the source node's edges.
+			typename edge_set::const_iterator last_;
 			friend class graph<N, E>;
 		};
 
+		using connection_range = std::ranges::subrange<connection_iterator>;
+
 		graph() = default;
 		graph(std::initializer_list<N> il);
 		template<typename InputIt>
@@ -159,8 +376,16 @@ namespace gdwg {
 		auto operator=(graph&& other) noexcept -> graph&;
 		auto operator=(graph const& other) -> graph&;
 
+		[[nodiscard]] auto snapshot() const -> graph;
+
 		auto insert_node(N const& value) -> bool;
+		template<typename InputIt>
+		auto insert_nodes(InputIt first, InputIt last) -> std::size_t;
 		auto insert_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) -> bool;
+		template<typename InputIt>
+		auto insert_edges(InputIt first, InputIt last) -> std::size_t;
+		template<typename ExecutionPolicy, typename InputIt>
+		auto insert_edges(ExecutionPolicy&& policy, InputIt first, InputIt last) -> std::size_t;
 		auto replace_node(N const& old_data, N const& new_data) -> bool;
 		auto merge_replace_node(N const& old_data, N const& new_data) -> void;
 		auto erase_node(N const& value) -> bool;
@@ -174,34 +399,275 @@ namespace gdwg {
 		[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
 		[[nodiscard]] auto nodes() const -> std::vector<N>;
 		[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto edges_view(N const& src, N const& dst) const -> edge_ref_range;
 		[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const -> iterator;
 		[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+		[[nodiscard]] auto connections_view(N const& src) const -> connection_range;
+		[[nodiscard]] auto out_degree(N const& value) const -> std::size_t;
+		[[nodiscard]] auto in_degree(N const& value) const -> std::size_t;
 
 		[[nodiscard]] auto begin() const -> iterator;
 		[[nodiscard]] auto end() const -> iterator;
+		[[nodiscard]] auto edge_refs() const -> edge_ref_range;
 
 		[[nodiscard]] auto operator==(graph const& other) const -> bool;
 		template<typename T, typename U>
 		friend auto operator<<(std::ostream& os, graph<T, U> const& g) -> std::ostream&;
+		friend struct std::hash<graph>;
 
 	 private:
-		struct node_cmp {
-			using is_transparent = void;
-			bool operator()(const std::shared_ptr<N>& lhs, const std::shared_ptr<N>& rhs) const {
-				return *lhs < *rhs;
+		// A block of storage that snapshots share until one of them changes it. write() copies the block first
+		// unless this is its only owner, and makes an empty one if there is none, so a change copies only the
+		// blocks on its way.
+		template<typename T>
+		class shared_block {
+		 public:
+			auto get() const noexcept -> T const* {
+				return ptr_.get();
 			}
+			auto is_shared() const noexcept -> bool {
+				return ptr_.use_count() > 1;
+			}
+			auto write() -> T& {
+				if (ptr_ == nullptr) {
+					ptr_ = std::make_shared<T>();
+				}
+				else if (ptr_.use_count() > 1) {
+					ptr_ = std::make_shared<T>(std::as_const(*ptr_));
+				}
+				else {
+					// The other owners let go with a release, so their last reads happen before this change.
+					std::atomic_thread_fence(std::memory_order_acquire);
+				}
+				return *ptr_;
+			}
+			template<typename... Args>
+			auto emplace(Args&&... args) -> T& {
+				ptr_ = std::make_shared<T>(std::forward<Args>(args)...);
+				return *ptr_;
+			}
+			auto reset() noexcept -> void {
+				ptr_.reset();
+			}
+
+		 private:
+			std::shared_ptr<T> ptr_;
+		};
+
+		// All edges from one source to one destination are adjacent in the source's block, so the run is described
+		// by its first edge and its length.
+		struct adjacency_entry {
+			typename edge_set::iterator first;
+			std::size_t count;
+		};
+		// Runs up to this long are searched by walking them, and longer ones by a search of the block.
+		static constexpr auto max_probed_run = std::size_t{8};
+		using adjacency_list = std::unordered_map<node_id, adjacency_entry>;
+
+		// The edges leaving one node, ordered by (dst, weight), and where each destination's run starts. A copy
+		// points at the same node objects, and finds its runs with one walk over its edges.
+		struct out_block {
+			out_block() = default;
+			out_block(out_block const& other);
+			auto operator=(out_block const&) -> out_block& = delete;
+
+			edge_set edges;
+			adjacency_list runs;
+		};
 
-			bool operator()(const std::shared_ptr<N>& lhs, const N& rhs) const {
-				return *lhs < rhs;
+		// The edges entering one node: every src with at least one edge to it, and how many edges there are.
+		struct in_block {
+			std::unordered_set<node_id> sources;
+			std::size_t degree = 0;
+		};
+
+		struct node_slot {
+			// Null while the id is free. A value is never changed in place, as a snapshot may share it.
+			std::shared_ptr<N const> value;
+			// boost::hash of the value, kept so edge hashes never rehash their endpoints.
+			std::size_t hash = 0;
+			shared_block<out_block> out;
+			shared_block<in_block> in;
+			// While the id is free, the next free id.
+			node_id next_free = no_node;
+		};
+
+		// Node value -> node id, keyed by the address of the stored value and its hash, and looked up by value.
+		struct id_key {
+			N const* value;
+			std::size_t hash;
+		};
+		struct id_probe {
+			N const& value;
+			std::size_t hash;
+		};
+		struct id_hash {
+			using is_transparent = void;
+			auto operator()(id_key const& key) const noexcept -> std::size_t {
+				return key.hash;
+			}
+			auto operator()(id_probe const& probe) const noexcept -> std::size_t {
+				return probe.hash;
+			}
+		};
+		struct id_equal {
+			using is_transparent = void;
+			bool operator()(id_key const& lhs, id_key const& rhs) const {
+				return *lhs.value == *rhs.value;
 			}
+			bool operator()(id_key const& lhs, id_probe const& rhs) const {
+				return *lhs.value == rhs.value;
+			}
+			bool operator()(id_probe const& lhs, id_key const& rhs) const {
+				return lhs.value == *rhs.value;
+			}
+		};
+		using id_shard = std::unordered_map<id_key, node_id, id_hash, id_equal>;
+
+		using node_chunk = std::vector<node_slot>;
+		using source_chunk = std::vector<node_id>;
+
+		// Node slots are stored in chunks of this many, so the first change to a node after a snapshot copies one
+		// chunk of slots rather than all of them.
+		static constexpr auto node_chunk_size = std::size_t{256};
+		// A chunk of sources_ is split in two when it grows past this many ids.
+		static constexpr auto source_chunk_size = std::size_t{512};
+		// ids_ doubles its number of shards when the average shard would hold more nodes than this.
+		static constexpr auto ids_per_shard = std::size_t{4096};
+
+		// An edge of an insert_edges() batch, before it is inserted.
+		struct pending_edge {
+			node_id src;
+			node_id dst;
+			std::optional<E> weight;
+		};
 
-			bool operator()(const N& lhs, const std::shared_ptr<N>& rhs) const {
-				return lhs < *rhs;
+		// Orders an insert_edges() batch as the graph orders edges. An id names one node, so edges with equal ids are
+		// ordered by weight, and differing nodes are compared by rank or, without ranks, by value.
+		struct batch_order {
+			graph const* g;
+			// Rank of every node by id, or null.
+			std::vector<node_id> const* ranks;
+
+			auto node_less(node_id lhs, node_id rhs) const -> bool {
+				return ranks != nullptr ? (*ranks)[lhs] < (*ranks)[rhs] : g->value_of(lhs) < g->value_of(rhs);
 			}
+			auto operator()(pending_edge const& lhs, pending_edge const& rhs) const -> bool {
+				if (lhs.src != rhs.src) {
+					return node_less(lhs.src, rhs.src);
+				}
+				if (lhs.dst != rhs.dst) {
+					return node_less(lhs.dst, rhs.dst);
+				}
+				return lhs.weight < rhs.weight;
+			}
+		};
+
+		// A run of edges incident to a node, taken out of its source's block while the node changes.
+		struct detached_run {
+			node_id src;
+			node_id dst;
+			std::size_t count;
+			// The edge that followed the run in its block, if it stays there.
+			std::optional<typename edge_set::iterator> next;
+		};
+		struct detached_edges {
+			std::vector<detached_run> runs;
+			// The edges of every run, run after run and in edge order within each run.
+			std::vector<typename edge_set::node_type> edges;
 		};
 
-		std::set<std::shared_ptr<N>, node_cmp> nodes_;
-		std::set<std::unique_ptr<edge>, edge_cmp> edges_;
+		static auto key_of(edge_record const& e) noexcept -> edge_key {
+			return {*e.src, *e.dst, e.weight ? &*e.weight : nullptr};
+		}
+		static auto key_of(pending_edge const& e, graph const& g) noexcept -> edge_key {
+			return {g.value_of(e.src), g.value_of(e.dst), e.weight ? &*e.weight : nullptr};
+		}
+		static auto make_edge(N const& src, N const& dst, std::optional<E> const& weight) -> std::unique_ptr<edge>;
+		auto make_record(node_id src, node_id dst, std::optional<E> weight) const -> edge_record;
+
+		auto slot(node_id id) const noexcept -> node_slot const& {
+			return (*(*nodes_.get())[id / node_chunk_size].get())[id % node_chunk_size];
+		}
+		auto slot_for_write(node_id id) -> node_slot& {
+			return nodes_.write()[id / node_chunk_size].write()[id % node_chunk_size];
+		}
+		auto value_of(node_id id) const noexcept -> N const& {
+			return *slot(id).value;
+		}
+		// Null when the node has never had an outgoing edge.
+		auto out_of(node_id id) const noexcept -> out_block const* {
+			return slot(id).out.get();
+		}
+		auto out_for_write(node_id id) -> out_block& {
+			return slot_for_write(id).out.write();
+		}
+		auto in_for_write(node_id id) -> in_block& {
+			return slot_for_write(id).in.write();
+		}
+		auto owns_block(node_id id) const noexcept -> bool;
+		static auto no_edges() -> edge_set const& {
+			static auto const none = edge_set{};
+			return none;
+		}
+
+		static auto shard_of(std::size_t hash, std::size_t shard_count) noexcept -> std::size_t {
+			return mix_hash(hash) & (shard_count - 1);
+		}
+		auto find_node(N const& value) const -> std::optional<node_id>;
+		auto index_ids(std::size_t shard_count) -> void;
+		auto reserve_ids(std::size_t count) -> void;
+		auto add_id(node_id id) -> void;
+		auto remove_id(node_id id) -> void;
+		auto sorted_nodes() const -> std::vector<node_id>;
+		auto batch_ranks(std::size_t batch_size) const -> std::vector<node_id>;
+		auto allocate_node(N value) -> node_id;
+		auto release_node(node_id id) -> void;
+
+		auto source_lower_bound(N const& value) const -> source_position;
+		auto source_at(source_position position) const -> std::optional<node_id>;
+		auto locate_source(node_id id, source_position hint) const -> source_position;
+		auto next_source(source_position position) const -> source_position;
+		auto prev_source(source_position position) const -> source_position;
+		auto add_source(node_id id) -> void;
+		auto remove_source(node_id id) -> void;
+		auto first_edge_from(source_position position) const -> edge_cursor;
+		auto last_edge_from(source_position position) const -> edge_cursor;
+		auto cursor_after(node_id src) const -> edge_cursor;
+		auto end_cursor() const -> edge_cursor {
+			return {this, nullptr, {}, 0, {}};
+		}
+
+		auto find_run(node_id src, node_id dst) const -> adjacency_entry const*;
+		auto edge_position(out_block const& block, node_id dst, edge_key const& key) const
+		    -> typename edge_set::iterator;
+		auto run_lower_bound(out_block const& block, adjacency_entry const& run, edge_key const& key) const
+		    -> typename edge_set::iterator;
+		template<typename InputIt>
+		auto resolve_edges(InputIt first, InputIt last) const -> std::vector<pending_edge>;
+		auto insert_sorted_edges(std::vector<pending_edge> const& batch) -> std::size_t;
+		auto index_edge(node_id src, out_block& block, typename edge_set::iterator it) -> typename edge_set::iterator;
+		auto unindex_edge(node_id src, out_block& block, typename edge_set::iterator it) -> void;
+		auto writable_edge(edge_cursor const& cursor) -> std::pair<out_block*, typename edge_set::iterator>;
+		auto detach_incident_edges(node_id id) -> detached_edges;
+		auto edge_hash(edge_record const& e) const -> std::size_t;
+
+		// Interning table: node id -> node, in chunks of node_chunk_size slots. Edges refer to their endpoints by
+		// id. Every level of storage is a shared_block, so snapshot() copies a handful of pointers and a change
+		// copies only the chunks and blocks it touches.
+		shared_block<std::vector<shared_block<node_chunk>>> nodes_;
+		std::size_t slot_count_ = 0;
+		// Head of the list of free ids, linked through their slots.
+		node_id free_head_ = no_node;
+		// Node value -> node id, sharded by hash so that a change copies one shard.
+		shared_block<std::vector<shared_block<id_shard>>> ids_;
+		std::size_t node_count_ = 0;
+		// Every node with outgoing edges, in ascending order, in chunks. Iteration walks their blocks in this order.
+		shared_block<std::vector<shared_block<source_chunk>>> sources_;
+		std::size_t edge_count_ = 0;
+		// Structural hash: the sum of the mixed hashes of every node and edge. A sum does not depend on insertion
+		// order and one element can be added or taken away in O(1), so every mutation keeps it up to date.
+		std::size_t hash_ = 0;
 	};
 
 	// Implementation of edge class member functions
@@ -270,66 +736,549 @@ namespace gdwg {
 	template<typename N, typename E>
 	template<typename InputIt>
 	graph<N, E>::graph(InputIt first, InputIt last) {
-		for (auto it = first; it != last; ++it) {
-			insert_node(*it);
-		}
+		insert_nodes(first, last);
 	}
 
 	template<typename N, typename E>
 	graph<N, E>::graph(graph&& other) noexcept
 	: nodes_(std::move(other.nodes_))
-	, edges_(std::move(other.edges_)) {}
-
+	, slot_count_(std::exchange(other.slot_count_, 0))
+	, free_head_(std::exchange(other.free_head_, no_node))
+	, ids_(std::move(other.ids_))
+	, node_count_(std::exchange(other.node_count_, 0))
+	, sources_(std::move(other.sources_))
+	, edge_count_(std::exchange(other.edge_count_, 0))
+	, hash_(std::exchange(other.hash_, 0)) {}
+
+	// Clones the structure instead of rebuilding it: each block's edge tree is copied node for node without a
+	// comparison, and its runs are found again with one walk over the copy. Every step is linear in the graph's size.
+	// Unlike a snapshot, the copy shares no storage with the original.
 	template<typename N, typename E>
-	graph<N, E>::graph(graph const& other) {
-		nodes_ = other.nodes_;
+	graph<N, E>::graph(graph const& other)
+	: slot_count_(other.slot_count_)
+	, free_head_(other.free_head_)
+	, node_count_(other.node_count_)
+	, edge_count_(other.edge_count_)
+	, hash_(other.hash_) {
+		if (other.nodes_.get() == nullptr) {
+			return;
+		}
 
-		for (const auto& edge_ptr : other.edges_) {
-			if (edge_ptr->is_weighted()) {
-				auto [src, dst] = edge_ptr->get_nodes();
-				auto weight = edge_ptr->get_weight();
-				edges_.insert(std::make_unique<weighted_edge<N, E>>(src, dst, *weight));
+		// Edges point at node objects, so the copy needs its own nodes for its edges to point at. Ids are kept.
+		auto& chunks = nodes_.write();
+		chunks.reserve(other.nodes_.get()->size());
+		for (auto const& from_chunk : *other.nodes_.get()) {
+			auto& chunk = chunks.emplace_back().write();
+			chunk.reserve(from_chunk.get()->size());
+			for (auto const& from : *from_chunk.get()) {
+				auto& copy = chunk.emplace_back();
+				if (from.value != nullptr) {
+					copy.value = std::make_shared<N const>(*from.value);
+				}
+				if (auto const* in = from.in.get(); in != nullptr and not in->sources.empty()) {
+					copy.in.write() = *in;
+				}
+				copy.hash = from.hash;
+				copy.next_free = from.next_free;
 			}
-			else {
-				auto [src, dst] = edge_ptr->get_nodes();
-				edges_.insert(std::make_unique<unweighted_edge<N, E>>(src, dst));
+		}
+
+		for (auto id = node_id{0}; id < slot_count_; ++id) {
+			auto const* from = other.out_of(id);
+			if (from == nullptr or from->edges.empty()) {
+				continue;
+			}
+			auto& block = slot_for_write(id).out.emplace(*from);
+			for (auto const& e : block.edges) {
+				// Pointing at this graph's copies of the same values leaves the edge order unchanged.
+				auto& record = const_cast<edge_record&>(e);
+				record.src = slot(e.src_id).value.get();
+				record.dst = slot(e.dst_id).value.get();
 			}
 		}
+
+		if (auto const* from = other.sources_.get(); from != nullptr) {
+			auto& sources = sources_.write();
+			sources.reserve(from->size());
+			for (auto const& chunk : *from) {
+				sources.emplace_back().emplace(*chunk.get());
+			}
+		}
+		index_ids(other.ids_.get() != nullptr ? other.ids_.get()->size() : std::size_t{1});
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::operator=(graph&& other) noexcept -> graph& {
 		if (this != &other) {
 			nodes_ = std::move(other.nodes_);
-			edges_ = std::move(other.edges_);
+			slot_count_ = std::exchange(other.slot_count_, 0);
+			free_head_ = std::exchange(other.free_head_, no_node);
+			ids_ = std::move(other.ids_);
+			node_count_ = std::exchange(other.node_count_, 0);
+			sources_ = std::move(other.sources_);
+			edge_count_ = std::exchange(other.edge_count_, 0);
+			hash_ = std::exchange(other.hash_, 0);
 		}
 		return *this;
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::operator=(graph const& other) -> graph& {
-		if (this == &other) {
-			return *this;
+		if (this != &other) {
+			*this = graph(other);
+		}
+		return *this;
+	}
+
+	// An O(1) copy that shares all of the graph's storage. Either graph copies a block the first time it changes
+	// it, so the other never sees the change: a write copies the chunk of node slots it touches, the blocks of
+	// edges entering and leaving the nodes it touches, and the chunks of ids_ and sources_ it updates.
+	//
+	// Taking a snapshot reads the graph, so it must not race with a change to the same graph object. The snapshot
+	// can then be read on another thread while the original keeps changing, and dropped on any thread. Once a
+	// snapshot shares a node's edges, the first change to them invalidates iterators and references to them.
+	template<typename N, typename E>
+	auto graph<N, E>::snapshot() const -> graph {
+		auto result = graph();
+		result.nodes_ = nodes_;
+		result.slot_count_ = slot_count_;
+		result.free_head_ = free_head_;
+		result.ids_ = ids_;
+		result.node_count_ = node_count_;
+		result.sources_ = sources_;
+		result.edge_count_ = edge_count_;
+		result.hash_ = hash_;
+		return result;
+	}
+
+	template<typename N, typename E>
+	graph<N, E>::out_block::out_block(out_block const& other)
+	: edges(other.edges) {
+		runs.reserve(other.runs.size());
+		for (auto it = edges.begin(); it != edges.end();) {
+			auto const dst = it->dst_id;
+			auto const count = other.runs.find(dst)->second.count;
+			runs.emplace(dst, adjacency_entry{it, count});
+			std::advance(it, static_cast<std::ptrdiff_t>(count));
 		}
-		nodes_ = other.nodes_;
-		edges_.clear();
-		for (const auto& edge_ptr : other.edges_) {
-			if (edge_ptr->is_weighted()) {
-				auto [src, dst] = edge_ptr->get_nodes();
-				auto weight = edge_ptr->get_weight();
-				edges_.insert(std::make_unique<weighted_edge<N, E>>(src, dst, *weight));
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::edge_cursor::next() -> void {
+		if (++it == block->edges.end()) {
+			*this = g->first_edge_from(g->next_source(g->locate_source(src, position)));
+		}
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::edge_cursor::prev() -> void {
+		if (block != nullptr and it != block->edges.begin()) {
+			--it;
+			return;
+		}
+		auto const* sources = g->sources_.get();
+		auto const from = block == nullptr ? source_position{sources->size(), 0} : g->locate_source(src, position);
+		*this = g->last_edge_from(g->prev_source(from));
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::make_edge(N const& src, N const& dst, std::optional<E> const& weight) -> std::unique_ptr<edge> {
+		if (weight) {
+			return std::make_unique<weighted_edge<N, E>>(src, dst, *weight);
+		}
+		return std::make_unique<unweighted_edge<N, E>>(src, dst);
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::make_record(node_id src, node_id dst, std::optional<E> weight) const -> edge_record {
+		return {slot(src).value.get(), slot(dst).value.get(), src, dst, std::move(weight)};
+	}
+
+	// Whether changing the node's edges leaves its block where it is. Any level on the way that a snapshot shares is
+	// copied first, and the block with it.
+	template<typename N, typename E>
+	auto graph<N, E>::owns_block(node_id id) const noexcept -> bool {
+		return not nodes_.is_shared() and not (*nodes_.get())[id / node_chunk_size].is_shared()
+		       and not slot(id).out.is_shared();
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::find_node(N const& value) const -> std::optional<node_id> {
+		auto const* shards = ids_.get();
+		if (shards == nullptr) {
+			return std::nullopt;
+		}
+		auto const hash = boost::hash<N>{}(value);
+		auto const* shard = (*shards)[shard_of(hash, shards->size())].get();
+		if (shard == nullptr) {
+			return std::nullopt;
+		}
+		auto it = shard->find(id_probe{value, hash});
+		if (it == shard->end()) {
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	// Rebuilds ids_ from the node slots, with the given power of two of shards.
+	template<typename N, typename E>
+	auto graph<N, E>::index_ids(std::size_t shard_count) -> void {
+		auto shards = std::vector<shared_block<id_shard>>(shard_count);
+		for (auto id = node_id{0}; id < slot_count_; ++id) {
+			auto const& s = slot(id);
+			if (s.value != nullptr) {
+				shards[shard_of(s.hash, shard_count)].write().emplace(id_key{s.value.get(), s.hash}, id);
 			}
-			else {
-				auto [src, dst] = edge_ptr->get_nodes();
-				edges_.insert(std::make_unique<unweighted_edge<N, E>>(src, dst));
+		}
+		ids_.emplace(std::move(shards));
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::reserve_ids(std::size_t count) -> void {
+		auto const* shards = ids_.get();
+		auto shard_count = shards != nullptr ? shards->size() : std::size_t{1};
+		while (shard_count * ids_per_shard < count) {
+			shard_count *= 2;
+		}
+		if (shards == nullptr or shard_count != shards->size()) {
+			index_ids(shard_count);
+		}
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::add_id(node_id id) -> void {
+		reserve_ids(node_count_ + 1);
+		auto& shards = ids_.write();
+		auto const& s = slot(id);
+		shards[shard_of(s.hash, shards.size())].write().emplace(id_key{s.value.get(), s.hash}, id);
+		++node_count_;
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::remove_id(node_id id) -> void {
+		auto& shards = ids_.write();
+		auto const& s = slot(id);
+		shards[shard_of(s.hash, shards.size())].write().erase(id_key{s.value.get(), s.hash});
+		--node_count_;
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::sorted_nodes() const -> std::vector<node_id> {
+		auto result = std::vector<node_id>{};
+		result.reserve(node_count_);
+		for (auto id = node_id{0}; id < slot_count_; ++id) {
+			if (slot(id).value != nullptr) {
+				result.push_back(id);
 			}
 		}
-		return *this;
+		std::sort(result.begin(), result.end(), [this](node_id lhs, node_id rhs) {
+			return value_of(lhs) < value_of(rhs);
+		});
+		return result;
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::allocate_node(N value) -> node_id {
+		auto id = free_head_;
+		if (id == no_node) {
+			id = static_cast<node_id>(slot_count_++);
+			auto& chunks = nodes_.write();
+			if (id % node_chunk_size == 0) {
+				chunks.emplace_back();
+			}
+			chunks.back().write().emplace_back();
+		}
+
+		auto& s = slot_for_write(id);
+		if (id == free_head_) {
+			free_head_ = std::exchange(s.next_free, no_node);
+		}
+		s.value = std::make_shared<N const>(std::move(value));
+		s.hash = boost::hash<N>{}(*s.value);
+		hash_ += mix_hash(s.hash);
+		add_id(id);
+		return id;
+	}
+
+	// The node must no longer have incident edges.
+	template<typename N, typename E>
+	auto graph<N, E>::release_node(node_id id) -> void {
+		hash_ -= mix_hash(slot(id).hash);
+		remove_id(id);
+		auto& s = slot_for_write(id);
+		s = node_slot{};
+		s.next_free = std::exchange(free_head_, id);
+	}
+
+	// The first position in sources_ whose node is not ordered before value. A chunk is never empty.
+	template<typename N, typename E>
+	auto graph<N, E>::source_lower_bound(N const& value) const -> source_position {
+		auto const* chunks = sources_.get();
+		if (chunks == nullptr) {
+			return {};
+		}
+		auto const before = [this](node_id id, N const& v) {
+			return value_of(id) < v;
+		};
+		auto const chunk = std::partition_point(chunks->begin(), chunks->end(), [&](auto const& ids) {
+			return before(ids.get()->back(), value);
+		});
+		if (chunk == chunks->end()) {
+			return {chunks->size(), 0};
+		}
+		auto const& ids = *chunk->get();
+		auto const offset = std::lower_bound(ids.begin(), ids.end(), value, before);
+		return {static_cast<std::size_t>(chunk - chunks->begin()), static_cast<std::size_t>(offset - ids.begin())};
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::source_at(source_position position) const -> std::optional<node_id> {
+		auto const* chunks = sources_.get();
+		if (chunks == nullptr or position.chunk == chunks->size()) {
+			return std::nullopt;
+		}
+		return (*(*chunks)[position.chunk].get())[position.offset];
+	}
+
+	// The position of a node with outgoing edges: hint if sources_ still has it there, else found by value.
+	template<typename N, typename E>
+	auto graph<N, E>::locate_source(node_id id, source_position hint) const -> source_position {
+		auto const& chunks = *sources_.get();
+		if (hint.chunk < chunks.size()) {
+			auto const& ids = *chunks[hint.chunk].get();
+			if (hint.offset < ids.size() and ids[hint.offset] == id) {
+				return hint;
+			}
+		}
+		return source_lower_bound(value_of(id));
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::next_source(source_position position) const -> source_position {
+		if (++position.offset == (*sources_.get())[position.chunk].get()->size()) {
+			return {position.chunk + 1, 0};
+		}
+		return position;
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::prev_source(source_position position) const -> source_position {
+		if (position.offset == 0) {
+			--position.chunk;
+			return {position.chunk, (*sources_.get())[position.chunk].get()->size() - 1};
+		}
+		--position.offset;
+		return position;
+	}
+
+	// Called when a node gains its first outgoing edge.
+	template<typename N, typename E>
+	auto graph<N, E>::add_source(node_id id) -> void {
+		auto& chunks = sources_.write();
+		auto position = source_position{};
+		if (chunks.empty()) {
+			chunks.emplace_back();
+		}
+		// Sources arrive in ascending order while a graph is built, and are then appended.
+		else if (auto const& last = *chunks.back().get(); value_of(last.back()) < value_of(id)) {
+			position = {chunks.size() - 1, last.size()};
+		}
+		else {
+			position = source_lower_bound(value_of(id));
+		}
+
+		auto& ids = chunks[position.chunk].write();
+		ids.insert(ids.begin() + static_cast<std::ptrdiff_t>(position.offset), id);
+		if (ids.size() > source_chunk_size) {
+			auto const middle = ids.begin() + static_cast<std::ptrdiff_t>(ids.size() / 2);
+			auto upper = source_chunk(middle, ids.end());
+			ids.erase(middle, ids.end());
+			auto const next = chunks.begin() + static_cast<std::ptrdiff_t>(position.chunk) + 1;
+			chunks.insert(next, shared_block<source_chunk>{})->emplace(std::move(upper));
+		}
+	}
+
+	// Called when a node loses its last outgoing edge, before its value changes.
+	template<typename N, typename E>
+	auto graph<N, E>::remove_source(node_id id) -> void {
+		auto const position = source_lower_bound(value_of(id));
+		auto& chunks = sources_.write();
+		auto& ids = chunks[position.chunk].write();
+		ids.erase(ids.begin() + static_cast<std::ptrdiff_t>(position.offset));
+		if (ids.empty()) {
+			chunks.erase(chunks.begin() + static_cast<std::ptrdiff_t>(position.chunk));
+		}
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::first_edge_from(source_position position) const -> edge_cursor {
+		auto const src = source_at(position);
+		if (not src) {
+			return end_cursor();
+		}
+		auto const* block = out_of(*src);
+		return {this, block, block->edges.begin(), *src, position};
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::last_edge_from(source_position position) const -> edge_cursor {
+		auto const src = *source_at(position);
+		auto const* block = out_of(src);
+		return {this, block, std::prev(block->edges.end()), src, position};
+	}
+
+	// The first edge of the first source after src, which need not have edges itself.
+	template<typename N, typename E>
+	auto graph<N, E>::cursor_after(node_id src) const -> edge_cursor {
+		auto position = source_lower_bound(value_of(src));
+		if (source_at(position) == src) {
+			position = next_source(position);
+		}
+		return first_edge_from(position);
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::find_run(node_id src, node_id dst) const -> adjacency_entry const* {
+		auto const* block = out_of(src);
+		if (block == nullptr) {
+			return nullptr;
+		}
+		auto it = block->runs.find(dst);
+		return it == block->runs.end() ? nullptr : &it->second;
+	}
+
+	// The first edge of the block not ordered before key, which must name the block's source and dst.
+	template<typename N, typename E>
+	auto graph<N, E>::edge_position(out_block const& block, node_id dst, edge_key const& key) const
+	    -> typename edge_set::iterator {
+		auto const run = block.runs.find(dst);
+		return run != block.runs.end() ? run_lower_bound(block, run->second, key) : block.edges.lower_bound(key);
+	}
+
+	// The first edge of the block not ordered before key, which must name the run's source and destination. The
+	// run is the equal range of (src, dst) in the block, so a short run is walked, which beats a full tree descent,
+	// and a long one is left to the O(log d) search.
+	template<typename N, typename E>
+	auto graph<N, E>::run_lower_bound(out_block const& block, adjacency_entry const& run, edge_key const& key) const
+	    -> typename edge_set::iterator {
+		if (run.count > max_probed_run) {
+			return block.edges.lower_bound(key);
+		}
+		auto const cmp = edge_cmp{};
+		auto it = run.first;
+		for (auto i = std::size_t{0}; i < run.count and cmp(*it, key); ++i) {
+			++it;
+		}
+		return it;
+	}
+
+	// Records an edge just inserted into src's block in the runs, the destination's in_block, the counters and
+	// sources_.
+	template<typename N, typename E>
+	auto graph<N, E>::index_edge(node_id src, out_block& block, typename edge_set::iterator it)
+	    -> typename edge_set::iterator {
+		auto [entry, inserted] = block.runs.try_emplace(it->dst_id, adjacency_entry{it, 0});
+		++entry->second.count;
+		auto& in = in_for_write(it->dst_id);
+		++in.degree;
+		if (inserted) {
+			in.sources.insert(src);
+		}
+		else if (edge_cmp{}(*it, *entry->second.first)) {
+			entry->second.first = it;
+		}
+		hash_ += edge_hash(*it);
+		++edge_count_;
+		if (block.edges.size() == 1) {
+			add_source(src);
+		}
+		return it;
+	}
+
+	// Undoes index_edge() for an edge about to be taken out of src's block.
+	template<typename N, typename E>
+	auto graph<N, E>::unindex_edge(node_id src, out_block& block, typename edge_set::iterator it) -> void {
+		auto entry = block.runs.find(it->dst_id);
+		auto& in = in_for_write(it->dst_id);
+		--in.degree;
+		hash_ -= edge_hash(*it);
+		--edge_count_;
+		if (--entry->second.count == 0) {
+			in.sources.erase(src);
+			block.runs.erase(entry);
+		}
+		else if (entry->second.first == it) {
+			entry->second.first = std::next(it);
+		}
+		if (block.edges.size() == 1) {
+			remove_source(src);
+		}
+	}
+
+	// Makes the block of the cursor's source writable, and finds the cursor's edge in it. When a snapshot shares
+	// the block it is copied, and the edge is found in the copy by a key taken while the old block is sure to live.
+	template<typename N, typename E>
+	auto graph<N, E>::writable_edge(edge_cursor const& cursor) -> std::pair<out_block*, typename edge_set::iterator> {
+		if (owns_block(cursor.src)) {
+			return {&out_for_write(cursor.src), cursor.it};
+		}
+		auto const e = pending_edge{cursor.src, cursor.it->dst_id, cursor.it->weight};
+		auto& block = out_for_write(e.src);
+		return {&block, block.edges.find(key_of(e, *this))};
+	}
+
+	// Extracts every edge incident to id, visiting only those edges, and drops them from the index.
+	template<typename N, typename E>
+	auto graph<N, E>::detach_incident_edges(node_id id) -> detached_edges {
+		auto result = detached_edges{};
+		auto const* own = out_of(id);
+		auto const* in = slot(id).in.get();
+		result.edges.reserve((own != nullptr ? own->edges.size() : 0) + (in != nullptr ? in->degree : 0));
+
+		auto const detach_run = [this, &result](node_id src, node_id dst, out_block& block, bool next_stays) {
+			auto const& run = block.runs.find(dst)->second;
+			auto const count = run.count;
+			auto it = run.first;
+			for (auto i = std::size_t{0}; i < count; ++i) {
+				unindex_edge(src, block, it);
+				result.edges.push_back(block.edges.extract(it++));
+			}
+			auto const next = next_stays and it != block.edges.end() ? std::optional(it) : std::nullopt;
+			result.runs.push_back({src, dst, count, next});
+		};
+
+		// The node's own block goes entirely, a self-loop run with it, so none of its runs has a successor that stays.
+		if (own != nullptr and not own->edges.empty()) {
+			auto& block = out_for_write(id);
+			while (not block.edges.empty()) {
+				detach_run(id, block.edges.begin()->dst_id, block, false);
+			}
+		}
+		// Any other source's run to the node is followed by an edge to another node, if by any.
+		in = slot(id).in.get();
+		if (in != nullptr) {
+			auto const sources = std::vector<node_id>(in->sources.begin(), in->sources.end());
+			for (auto const src : sources) {
+				detach_run(src, id, out_for_write(src), true);
+			}
+		}
+		return result;
+	}
+
+	template<typename N, typename E>
+	auto graph<N, E>::edge_hash(edge_record const& e) const -> std::size_t {
+		auto seed = slot(e.src_id).hash;
+		boost::hash_combine(seed, slot(e.dst_id).hash);
+		boost::hash_combine(seed, e.weight.has_value());
+		if (e.weight) {
+			boost::hash_combine(seed, *e.weight);
+		}
+		return mix_hash(seed);
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::is_node(N const& value) const noexcept -> bool {
-		return nodes_.find(value) != nodes_.end();
+		return find_node(value).has_value();
 	}
 
 	template<typename N, typename E>
@@ -337,37 +1286,159 @@ namespace gdwg {
 		if (is_node(value)) {
 			return false;
 		}
-		auto node = std::make_shared<N>(value);
-		auto result = nodes_.insert(node);
-		return result.second;
+		allocate_node(value);
+		return true;
+	}
+
+	template<typename N, typename E>
+	template<typename InputIt>
+	auto graph<N, E>::insert_nodes(InputIt first, InputIt last) -> std::size_t {
+		if constexpr (std::forward_iterator<InputIt>) {
+			auto const size = node_count_ + static_cast<std::size_t>(std::distance(first, last));
+			auto& chunks = nodes_.write();
+			auto const chunk_count = (size + node_chunk_size - 1) / node_chunk_size;
+			if (chunks.capacity() < chunk_count) {
+				chunks.reserve(std::max(chunk_count, 2 * chunks.capacity()));
+			}
+			reserve_ids(size);
+		}
+
+		auto inserted = std::size_t{0};
+		for (auto it = first; it != last; ++it) {
+			inserted += static_cast<std::size_t>(insert_node(*it));
+		}
+		return inserted;
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::insert_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
-		if (not is_node(src) or not is_node(dst)) {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
 			throw std::runtime_error("Cannot call gdwg::graph<N, E>::insert_edge when either src or dst node does not "
 			                         "exist");
 		}
 
-		auto new_edge = std::unique_ptr<edge>{};
-		if (weight) {
-			new_edge = std::make_unique<weighted_edge<N, E>>(src, dst, *weight);
+		// The position the edge is looked up at is where it goes when it is new. A duplicate is found before the
+		// block is written, so it never copies a block that a snapshot shares.
+		auto const key = edge_key{value_of(*src_id), value_of(*dst_id), weight ? &*weight : nullptr};
+		auto const* block = out_of(*src_id);
+		auto hint = typename edge_set::iterator{};
+		if (block != nullptr) {
+			hint = edge_position(*block, *dst_id, key);
+			if (hint != block->edges.end() and not edge_cmp{}(key, *hint)) {
+				return false;
+			}
 		}
-		else {
-			new_edge = std::make_unique<unweighted_edge<N, E>>(src, dst);
+
+		auto& target = out_for_write(*src_id);
+		if (&target != block) {
+			hint = edge_position(target, *dst_id, key);
 		}
+		index_edge(*src_id, target, target.edges.insert(hint, make_record(*src_id, *dst_id, std::move(weight))));
+		return true;
+	}
 
-		if (edges_.find(new_edge) != edges_.end()) {
-			return false;
+	template<typename N, typename E>
+	template<typename InputIt>
+	auto graph<N, E>::insert_edges(InputIt first, InputIt last) -> std::size_t {
+		auto batch = resolve_edges(first, last);
+		auto const ranks = batch_ranks(batch.size());
+		auto const order = batch_order{this, ranks.empty() ? nullptr : &ranks};
+		// Batches read back from a saved graph arrive in edge order already.
+		if (not std::is_sorted(batch.begin(), batch.end(), order)) {
+			std::sort(batch.begin(), batch.end(), order);
 		}
+		return insert_sorted_edges(batch);
+	}
 
-		edges_.insert(std::move(new_edge));
-		return true;
+	// Same as insert_edges(first, last), but checks and sorts the batch under the given standard execution policy.
+	template<typename N, typename E>
+	template<typename ExecutionPolicy, typename InputIt>
+	auto graph<N, E>::insert_edges(ExecutionPolicy&& policy, InputIt first, InputIt last) -> std::size_t {
+		auto batch = resolve_edges(first, last);
+		auto const ranks = batch_ranks(batch.size());
+		auto const order = batch_order{this, ranks.empty() ? nullptr : &ranks};
+		if (not std::is_sorted(policy, batch.begin(), batch.end(), order)) {
+			std::sort(policy, batch.begin(), batch.end(), order);
+		}
+		return insert_sorted_edges(batch);
+	}
+
+	// Ranking every node costs O(V log V) but turns each comparison of a sort into an integer comparison, which pays
+	// off once a batch has as many edges as the graph has nodes. Smaller batches get no ranks and compare node values,
+	// so their cost does not depend on the size of the graph.
+	template<typename N, typename E>
+	auto graph<N, E>::batch_ranks(std::size_t batch_size) const -> std::vector<node_id> {
+		if (batch_size < node_count_) {
+			return {};
+		}
+		auto ranks = std::vector<node_id>(slot_count_);
+		auto rank = node_id{0};
+		for (auto const id : sorted_nodes()) {
+			ranks[id] = rank++;
+		}
+		return ranks;
+	}
+
+	// Resolves every (src, dst, weight) tuple of the range to node ids before anything is inserted.
+	template<typename N, typename E>
+	template<typename InputIt>
+	auto graph<N, E>::resolve_edges(InputIt first, InputIt last) const -> std::vector<pending_edge> {
+		auto batch = std::vector<pending_edge>{};
+		if constexpr (std::forward_iterator<InputIt>) {
+			batch.reserve(static_cast<std::size_t>(std::distance(first, last)));
+		}
+
+		for (auto it = first; it != last; ++it) {
+			auto const& [src, dst, weight] = *it;
+			auto const src_id = find_node(src);
+			auto const dst_id = find_node(dst);
+			if (not src_id or not dst_id) {
+				throw std::runtime_error("Cannot call gdwg::graph<N, E>::insert_edges when either src or dst node does "
+				                         "not exist");
+			}
+			batch.push_back({*src_id, *dst_id, weight});
+		}
+		return batch;
+	}
+
+	// Inserts a batch sorted in edge order in one forward pass over each source's block. Each new edge goes in just
+	// before a cursor at its position, so filling an empty graph costs amortised O(1) per edge.
+	template<typename N, typename E>
+	auto graph<N, E>::insert_sorted_edges(std::vector<pending_edge> const& batch) -> std::size_t {
+		auto const cmp = edge_cmp{};
+		auto* block = static_cast<out_block*>(nullptr);
+		auto cursor = typename edge_set::iterator{};
+		auto inserted = std::size_t{0};
+		for (auto i = std::size_t{0}; i < batch.size(); ++i) {
+			auto const& e = batch[i];
+			if (i > 0 and e.src == batch[i - 1].src and e.dst == batch[i - 1].dst and e.weight == batch[i - 1].weight) {
+				continue;
+			}
+			if (i == 0 or e.src != batch[i - 1].src) {
+				block = &out_for_write(e.src);
+				cursor = block->edges.begin();
+			}
+
+			auto const key = key_of(e, *this);
+			if (cursor != block->edges.end() and cmp(*cursor, key)) {
+				cursor = block->edges.lower_bound(key);
+			}
+			if (cursor != block->edges.end() and not cmp(key, *cursor)) {
+				continue;
+			}
+
+			index_edge(e.src, *block, block->edges.insert(cursor, make_record(e.src, e.dst, e.weight)));
+			++inserted;
+		}
+		return inserted;
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::replace_node(N const& old_data, N const& new_data) -> bool {
-		if (not is_node(old_data)) {
+		auto const found = find_node(old_data);
+		if (not found) {
 			throw std::runtime_error("Cannot call gdwg::graph<N, E>::replace_node on a node that doesn't exist");
 		}
 
@@ -375,73 +1446,62 @@ namespace gdwg {
 			return false;
 		}
 
-		auto old_node_it = nodes_.find(old_data);
-		auto new_node = std::make_shared<N>(new_data);
-		nodes_.erase(old_node_it);
-		nodes_.insert(new_node);
-
-		std::vector<std::unique_ptr<edge>> new_edges;
-		for (auto it = edges_.begin(); it != edges_.end();) {
-			auto& e = *it;
-			auto nodes = e->get_nodes();
-			bool modified = false;
-			if (nodes.first == old_data) {
-				nodes.first = new_data;
-				modified = true;
-			}
-			if (nodes.second == old_data) {
-				nodes.second = new_data;
-				modified = true;
-			}
-			if (modified) {
-				if (e->is_weighted()) {
-					new_edges.push_back(
-					    std::make_unique<weighted_edge<N, E>>(nodes.first, nodes.second, *e->get_weight()));
-				}
-				else {
-					new_edges.push_back(std::make_unique<unweighted_edge<N, E>>(nodes.first, nodes.second));
-				}
-				it = edges_.erase(it);
+		// Only the d edges incident to the node are taken out of their blocks while its value, and therefore their
+		// position, changes. Each run goes back before the edge that used to follow it, which costs O(1) per edge
+		// when the new value keeps the run in place and O(log d) otherwise.
+		auto const id = *found;
+		auto detached = detach_incident_edges(id);
+
+		hash_ -= mix_hash(slot(id).hash);
+		remove_id(id);
+		auto& s = slot_for_write(id);
+		s.value = std::make_shared<N const>(new_data);
+		s.hash = boost::hash<N>{}(new_data);
+		hash_ += mix_hash(s.hash);
+		add_id(id);
+
+		auto e = detached.edges.begin();
+		for (auto const& run : detached.runs) {
+			auto& block = out_for_write(run.src);
+			for (auto i = std::size_t{0}; i < run.count; ++i) {
+				auto& record = e[static_cast<std::ptrdiff_t>(i)].value();
+				record.src = slot(run.src).value.get();
+				record.dst = slot(run.dst).value.get();
 			}
-			else {
-				++it;
+			auto const hint = run.next ? *run.next : block.edges.lower_bound(key_of(e->value()));
+			for (auto i = std::size_t{0}; i < run.count; ++i, ++e) {
+				index_edge(run.src, block, block.edges.insert(hint, std::move(*e)));
 			}
 		}
 
-		for (auto& new_edge : new_edges) {
-			edges_.insert(std::move(new_edge));
-		}
-
 		return true;
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::is_connected(N const& src, N const& dst) const -> bool {
-		if (not is_node(src) or not is_node(dst)) {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
 			throw std::runtime_error("Cannot call gdwg::graph<N, E>::is_connected if src or dst node don't exist in "
 			                         "the graph");
 		}
 
-		for (const auto& edge : edges_) {
-			auto nodes = edge->get_nodes();
-			if (nodes.first == src and nodes.second == dst) {
-				return true;
-			}
-		}
-		return false;
+		return find_run(*src_id, *dst_id) != nullptr;
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::empty() const noexcept -> bool {
-		return nodes_.empty();
+		return node_count_ == 0;
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::nodes() const -> std::vector<N> {
 		std::vector<N> result;
-		result.reserve(nodes_.size());
-		for (const auto& node_ptr : nodes_) {
-			result.push_back(*node_ptr);
+		result.reserve(node_count_);
+		for (auto id = node_id{0}; id < slot_count_; ++id) {
+			if (auto const& value = slot(id).value; value != nullptr) {
+				result.push_back(*value);
+			}
 		}
 		std::sort(result.begin(), result.end());
 		return result;
@@ -449,244 +1509,363 @@ namespace gdwg {
 
 	template<typename N, typename E>
 	auto graph<N, E>::merge_replace_node(N const& old_data, N const& new_data) -> void {
-		if (not is_node(old_data) or not is_node(new_data)) {
+		auto const old_id = find_node(old_data);
+		auto const new_id = find_node(new_data);
+		if (not old_id or not new_id) {
 			throw std::runtime_error("Cannot call gdwg::graph<N, E>::merge_replace_node on old or new data if they "
 			                         "don't exist in the graph");
 		}
 
-		auto new_edges = std::vector<std::unique_ptr<edge>>{};
-		for (auto it = edges_.begin(); it != edges_.end();) {
-			auto& e = *it;
-			auto nodes = e->get_nodes();
-			auto modified = false;
-
-			if (nodes.first == old_data) {
-				nodes.first = new_data;
-				modified = true;
-			}
-			if (nodes.second == old_data) {
-				nodes.second = new_data;
-				modified = true;
-			}
+		if (*old_id == *new_id) {
+			return;
+		}
 
-			if (modified) {
-				auto new_edge = std::unique_ptr<edge>{};
-				if (e->is_weighted()) {
-					new_edge = std::make_unique<weighted_edge<N, E>>(nodes.first, nodes.second, *e->get_weight());
-				}
-				else {
-					new_edge = std::make_unique<unweighted_edge<N, E>>(nodes.first, nodes.second);
+		// Each run incident to old_data is relinked to new_data and merged into the run it now belongs to. Both are
+		// ordered by weight, so one forward walk of the target run drops duplicates and places every other edge.
+		auto const cmp = edge_cmp{};
+		auto detached = detach_incident_edges(*old_id);
+		auto e = detached.edges.begin();
+		for (auto const& run : detached.runs) {
+			auto const src = run.src == *old_id ? *new_id : run.src;
+			auto const dst = run.dst == *old_id ? *new_id : run.dst;
+			auto& block = out_for_write(src);
+			auto const target = block.runs.find(dst);
+			auto remaining = target != block.runs.end() ? target->second.count : std::size_t{0};
+			auto cursor = typename edge_set::iterator{};
+
+			for (auto i = std::size_t{0}; i < run.count; ++i, ++e) {
+				auto& moved = e->value();
+				moved.src = slot(src).value.get();
+				moved.dst = slot(dst).value.get();
+				moved.src_id = src;
+				moved.dst_id = dst;
+				if (i == 0) {
+					cursor = remaining > 0 ? target->second.first : block.edges.lower_bound(key_of(moved));
 				}
 
-				if (edges_.find(new_edge) == edges_.end()) {
-					new_edges.push_back(std::move(new_edge));
+				while (remaining > 0 and cmp(*cursor, e->value())) {
+					++cursor;
+					--remaining;
 				}
-
-				it = edges_.erase(it);
-			}
-			else {
-				++it;
+				if (remaining > 0 and not cmp(e->value(), *cursor)) {
+					continue;
+				}
+				index_edge(src, block, block.edges.insert(cursor, std::move(*e)));
 			}
 		}
-		for (auto& new_edge : new_edges) {
-			edges_.insert(std::move(new_edge));
-		}
-		auto old_node_it = nodes_.find(old_data);
-		nodes_.erase(old_node_it);
+		release_node(*old_id);
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::erase_node(N const& value) -> bool {
-		auto node_it = nodes_.find(value);
-		if (node_it == nodes_.end()) {
+		auto const id = find_node(value);
+		if (not id) {
 			return false;
 		}
 
-		for (auto it = edges_.begin(); it != edges_.end();) {
-			auto nodes = (*it)->get_nodes();
-			if (nodes.first == value or nodes.second == value) {
-				it = edges_.erase(it);
+		// Only the runs named by the node's own blocks are visited, so this is O(d) in its degree d. Its own block
+		// is dropped whole, and a self-loop run with it, which also drops it from the incoming set before that is
+		// walked.
+		if (auto const* own = out_of(*id); own != nullptr and not own->edges.empty()) {
+			for (auto const& e : own->edges) {
+				hash_ -= edge_hash(e);
 			}
-			else {
-				++it;
+			for (auto const& [dst, run] : own->runs) {
+				auto& in = in_for_write(dst);
+				in.sources.erase(*id);
+				in.degree -= run.count;
+			}
+			edge_count_ -= own->edges.size();
+			remove_source(*id);
+		}
+		if (auto const* in = slot(*id).in.get(); in != nullptr) {
+			for (auto const src : in->sources) {
+				auto& block = out_for_write(src);
+				auto const entry = block.runs.find(*id);
+				auto const count = entry->second.count;
+				auto last = entry->second.first;
+				for (auto i = std::size_t{0}; i < count; ++i, ++last) {
+					hash_ -= edge_hash(*last);
+				}
+				block.edges.erase(entry->second.first, last);
+				block.runs.erase(entry);
+				edge_count_ -= count;
+				if (block.edges.empty()) {
+					remove_source(src);
+				}
 			}
 		}
 
-		nodes_.erase(node_it);
+		release_node(*id);
 
 		return true;
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::erase_edge(N const& src, N const& dst, std::optional<E> weight) -> bool {
-		if (not is_node(src) or not is_node(dst)) {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
 			throw std::runtime_error("Cannot call gdwg::graph<N, E>::erase_edge on src or dst if they don't exist in "
 			                         "the graph");
 		}
 
-		for (auto it = edges_.begin(); it != edges_.end(); ++it) {
-			auto& e = *it;
-			auto nodes = e->get_nodes();
-			if (nodes.first == src and nodes.second == dst) {
-				if (not weight.has_value() and not e->is_weighted()) {
-					edges_.erase(it);
-					return true;
-				}
-				if (weight.has_value() and e->is_weighted() and e->get_weight() == weight) {
-					edges_.erase(it);
-					return true;
-				}
-			}
+		// A missing edge is found missing before the block is written, as in insert_edge().
+		if (find_run(*src_id, *dst_id) == nullptr) {
+			return false;
 		}
-		return false;
+		auto const key = edge_key{value_of(*src_id), value_of(*dst_id), weight ? &*weight : nullptr};
+		auto const* block = out_of(*src_id);
+		auto const found = edge_position(*block, *dst_id, key);
+		if (found == block->edges.end() or edge_cmp{}(key, *found)) {
+			return false;
+		}
+		auto [target, it] = writable_edge(edge_cursor{this, block, found, *src_id, {}});
+		unindex_edge(*src_id, *target, it);
+		target->edges.erase(it);
+		return true;
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::erase_edge(iterator i) -> iterator {
-		auto it = i.it_;
-		auto next_it = edges_.erase(it);
-
-		return iterator(next_it);
+		auto const src = i.cursor_.src;
+		auto [block, it] = writable_edge(i.cursor_);
+		unindex_edge(src, *block, it);
+		auto const next = block->edges.erase(it);
+		if (next != block->edges.end()) {
+			return iterator(edge_cursor{this, block, next, src, i.cursor_.position});
+		}
+		return iterator(cursor_after(src));
 	}
 
+	// s is held as a key, as it stops pointing into the graph if its block is copied on the way.
 	template<typename N, typename E>
 	auto graph<N, E>::erase_edge(iterator i, iterator s) -> iterator {
-		auto it = i.it_;
-		auto end_it = s.it_;
-		auto next_it = edges_.erase(it, end_it);
-
-		return iterator(next_it);
+		auto const& last = s.cursor_;
+		auto stop = std::optional<pending_edge>{};
+		if (last.block != nullptr) {
+			stop = pending_edge{last.src, last.it->dst_id, last.it->weight};
+		}
+		while (i.cursor_.block != nullptr and (not stop or edge_cmp{}(*i.cursor_.it, key_of(*stop, *this)))) {
+			i = erase_edge(i);
+		}
+		return i;
 	}
 
 	template<typename N, typename E>
 	auto graph<N, E>::clear() noexcept -> void {
-		nodes_.clear();
-		edges_.clear();
+		nodes_.reset();
+		slot_count_ = 0;
+		free_head_ = no_node;
+		ids_.reset();
+		node_count_ = 0;
+		sources_.reset();
+		edge_count_ = 0;
+		hash_ = 0;
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const -> iterator {
-		for (auto it = edges_.begin(); it != edges_.end(); ++it) {
-			auto& e = *it;
-			auto nodes = e->get_nodes();
-			if (nodes.first == src and nodes.second == dst) {
-				if (not weight.has_value() and not e->is_weighted()) {
-					return iterator(it);
-				}
-				if (weight.has_value() and e->is_weighted() and e->get_weight() == weight) {
-					return iterator(it);
-				}
-			}
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id or find_run(*src_id, *dst_id) == nullptr) {
+			return end();
 		}
 
-		return end();
+		auto const key = edge_key{value_of(*src_id), value_of(*dst_id), weight ? &*weight : nullptr};
+		auto const* block = out_of(*src_id);
+		auto const it = edge_position(*block, *dst_id, key);
+		if (it == block->edges.end() or edge_cmp{}(key, *it)) {
+			return end();
+		}
+		return iterator(edge_cursor{this, block, it, *src_id, {}});
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::begin() const -> iterator {
-		return iterator(edges_.begin());
+		return iterator(first_edge_from({}));
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::end() const -> iterator {
-		return iterator(edges_.end());
+		return iterator(end_cursor());
+	}
+
+	// Every edge in iteration order, like [begin(), end()), with nothing copied on dereference.
+	template<typename N, typename E>
+	[[nodiscard]] auto graph<N, E>::edge_refs() const -> edge_ref_range {
+		return {edge_ref_iterator(first_edge_from({})), edge_ref_iterator(end_cursor())};
 	}
 
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::connections(N const& src) const -> std::vector<N> {
-		if (not is_node(src)) {
+		auto const src_id = find_node(src);
+		if (not src_id) {
 			throw std::runtime_error("Cannot call gdwg::graph<N, E>::connections if src doesn't exist in the graph");
 		}
 
+		// The block is ordered by destination, so the result needs no sort.
 		auto connected_nodes = std::vector<N>{};
-		for (const auto& e : edges_) {
-			auto nodes = e->get_nodes();
-			if (nodes.first == src) {
-				connected_nodes.push_back(nodes.second);
+		if (auto const* block = out_of(*src_id); block != nullptr) {
+			connected_nodes.reserve(block->edges.size());
+			for (auto const& e : block->edges) {
+				connected_nodes.push_back(*e.dst);
 			}
 		}
-
-		std::sort(connected_nodes.begin(), connected_nodes.end());
 		return connected_nodes;
 	}
 
+	// The destinations of connections(src) without repeats, read in place from src's block of edges in O(1).
+	template<typename N, typename E>
+	[[nodiscard]] auto graph<N, E>::connections_view(N const& src) const -> connection_range {
+		auto const src_id = find_node(src);
+		if (not src_id) {
+			throw std::runtime_error("Cannot call gdwg::graph<N, E>::connections_view if src doesn't exist in the "
+			                         "graph");
+		}
+
+		auto const* block = out_of(*src_id);
+		auto const& edges = block != nullptr ? block->edges : no_edges();
+		return {connection_iterator(edges.begin(), edges.end()), connection_iterator(edges.end(), edges.end())};
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto graph<N, E>::out_degree(N const& value) const -> std::size_t {
+		auto const id = find_node(value);
+		if (not id) {
+			throw std::runtime_error("Cannot call gdwg::graph<N, E>::out_degree if the node doesn't exist in the "
+			                         "graph");
+		}
+		auto const* block = out_of(*id);
+		return block != nullptr ? block->edges.size() : 0;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto graph<N, E>::in_degree(N const& value) const -> std::size_t {
+		auto const id = find_node(value);
+		if (not id) {
+			throw std::runtime_error("Cannot call gdwg::graph<N, E>::in_degree if the node doesn't exist in the graph");
+		}
+		auto const* in = slot(*id).in.get();
+		return in != nullptr ? in->degree : 0;
+	}
+
 	template<typename N, typename E>
 	[[nodiscard]] auto graph<N, E>::edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>> {
-		if (not is_node(src) or not is_node(dst)) {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
 			throw std::runtime_error("Cannot call gdwg::graph<N, E>::edges if src or dst node don't exist in the "
 			                         "graph");
 		}
 
 		auto result = std::vector<std::unique_ptr<edge>>{};
+		auto const* run = find_run(*src_id, *dst_id);
+		if (run == nullptr) {
+			return result;
+		}
 
-		for (const auto& e : edges_) {
-			auto nodes = e->get_nodes();
-			if (nodes.first == src and nodes.second == dst) {
-				if (e->is_weighted()) {
-					result.push_back(std::make_unique<weighted_edge<N, E>>(nodes.first, nodes.second, *e->get_weight()));
-				}
-				else {
-					result.push_back(std::make_unique<unweighted_edge<N, E>>(nodes.first, nodes.second));
-				}
-			}
+		// Returned edges own copies of their nodes so that they stay valid after the graph changes.
+		result.reserve(run->count);
+		auto it = run->first;
+		for (auto i = std::size_t{0}; i < run->count; ++i, ++it) {
+			result.push_back(make_edge(src, dst, it->weight));
 		}
 
 		return result;
 	}
 
+	// Same edges as edges(src, dst), in the same order, but nothing is copied or allocated.
 	template<typename N, typename E>
-	[[nodiscard]] auto graph<N, E>::operator==(graph const& other) const -> bool {
-		if (nodes_.size() != other.nodes_.size()) {
-			return false;
+	[[nodiscard]] auto graph<N, E>::edges_view(N const& src, N const& dst) const -> edge_ref_range {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
+			throw std::runtime_error("Cannot call gdwg::graph<N, E>::edges_view if src or dst node don't exist in the "
+			                         "graph");
 		}
 
-		for (const auto& node : nodes_) {
-			if (not other.is_node(*node)) {
-				return false;
-			}
+		auto const* run = find_run(*src_id, *dst_id);
+		if (run == nullptr) {
+			return {edge_ref_iterator(end_cursor()), edge_ref_iterator(end_cursor())};
+		}
+		// The run's end is searched for rather than stepped to, so this is O(log d) however long the run is. When
+		// the run ends its block, the range ends at the next source's first edge.
+		auto const* block = out_of(*src_id);
+		auto const last = block->edges.upper_bound(run_key{value_of(*src_id), value_of(*dst_id)});
+		auto const first = edge_cursor{this, block, run->first, *src_id, {}};
+		if (last == block->edges.end()) {
+			return {edge_ref_iterator(first), edge_ref_iterator(cursor_after(*src_id))};
 		}
+		return {edge_ref_iterator(first), edge_ref_iterator(edge_cursor{this, block, last, *src_id, {}})};
+	}
 
-		if (edges_.size() != other.edges_.size()) {
+	template<typename N, typename E>
+	[[nodiscard]] auto graph<N, E>::operator==(graph const& other) const -> bool {
+		if (hash_ != other.hash_ or node_count_ != other.node_count_ or edge_count_ != other.edge_count_) {
 			return false;
 		}
 
-		for (const auto& edge : edges_) {
-			auto nodes = edge->get_nodes();
-			auto weight = edge->get_weight();
-
-			auto it = std::find_if(other.edges_.begin(),
-			                       other.edges_.end(),
-			                       [&nodes, &weight](const std::unique_ptr<typename graph<N, E>::edge>& e) {
-				                       return e->get_nodes() == nodes and e->get_weight() == weight;
-			                       });
-
-			if (it == other.edges_.end()) {
+		for (auto id = node_id{0}; id < slot_count_; ++id) {
+			if (auto const& value = slot(id).value; value != nullptr and not other.is_node(*value)) {
 				return false;
 			}
 		}
 
-		return true;
+		// Both graphs order their edges by (src, dst, weight) values, so equal graphs list equal edges in the same
+		// order.
+		auto const same_edge = [](edge_ref const& lhs, edge_ref const& rhs) {
+			if (lhs.from != rhs.from or lhs.to != rhs.to or (lhs.weight == nullptr) != (rhs.weight == nullptr)) {
+				return false;
+			}
+			return lhs.weight == nullptr or *lhs.weight == *rhs.weight;
+		};
+		auto const lhs = edge_refs();
+		auto const rhs = other.edge_refs();
+		return std::equal(lhs.begin(), lhs.end(), rhs.begin(), same_edge);
 	}
 
+	// Each node's block holds its edges in the same ascending order as the output, so the blocks are walked in node
+	// order. Each block's lines are formatted into one buffer, as print_edge() would format them, and written out in
+	// string order; they usually already are, and then the buffer is written as it is.
 	template<typename N, typename E>
 	auto operator<<(std::ostream& os, graph<N, E> const& g) -> std::ostream& {
-		os << "\n";
-		for (const auto& node : g.nodes_) {
-			os << *node << " (\n";
-
-			auto edges = std::vector<std::string>{};
+		auto buffer = std::ostringstream{};
+		// Each line of the block, without its newline, as (offset, length) in the buffer.
+		auto lines = std::vector<std::pair<std::size_t, std::size_t>>{};
 
-			for (const auto& edge : g.edges_) {
-				auto nodes = edge->get_nodes();
-				if (nodes.first == *node) {
-					edges.push_back("  " + edge->print_edge());
+		os << "\n";
+		for (auto const id : g.sorted_nodes()) {
+			os << g.value_of(id) << " (\n";
+
+			buffer.str({});
+			lines.clear();
+			auto const* block = g.out_of(id);
+			for (auto const& edge : block != nullptr ? block->edges : g.no_edges()) {
+				auto const offset = buffer.view().size();
+				buffer << "  " << *edge.src << " -> " << *edge.dst;
+				if (edge.weight) {
+					buffer << " | W | " << *edge.weight;
+				}
+				else {
+					buffer << " | U";
 				}
+				lines.emplace_back(offset, buffer.view().size() - offset);
+				buffer << '\n';
 			}
 
-			std::sort(edges.begin(), edges.end());
-
-			for (const auto& edge_str : edges) {
-				os << edge_str << "\n";
+			auto const text = buffer.view();
+			auto const line_less = [text](auto const& lhs, auto const& rhs) {
+				return text.substr(lhs.first, lhs.second) < text.substr(rhs.first, rhs.second);
+			};
+			if (std::is_sorted(lines.begin(), lines.end(), line_less)) {
+				os.write(text.data(), static_cast<std::streamsize>(text.size()));
+			}
+			else {
+				std::sort(lines.begin(), lines.end(), line_less);
+				for (auto const& [offset, length] : lines) {
+					os.write(text.data() + offset, static_cast<std::streamsize>(length + 1));
+				}
 			}
 
 			os << ")\n";
@@ -696,4 +1875,13 @@ namespace gdwg {
 
 } // namespace gdwg
 
+// Equal graphs hash equally whatever order their nodes and edges were inserted in. The hash is maintained by every
+// mutation, so this is O(1).
+template<typename N, typename E>
+struct std::hash<gdwg::graph<N, E>> {
+	auto operator()(gdwg::graph<N, E> const& g) const noexcept -> std::size_t {
+		return g.hash_;
+	}
+};
+
 #endif // GDWG_GRAPH_H
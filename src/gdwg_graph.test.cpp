@@ -1,7 +1,13 @@
 #include "gdwg_graph.h"
+#include "gdwg_test_helpers.h"
 
 #include <catch2/catch.hpp>
 
+#include <execution>
+#include <random>
+
+using gdwg::test::edge_list;
+
 TEST_CASE("Test constructors for gdwg::graph", "[graph][constructor]") {
 	SECTION("Default constructor") {
 		auto g = gdwg::graph<std::string, int>{};
@@ -62,6 +68,33 @@ TEST_CASE("Test graph copy and move constructors") {
 		REQUIRE_FALSE(g_copy.is_connected(1, 3));
 	}
 
+	SECTION("Test copy constructor produces an independent graph") {
+		g.insert_edge(1, 2);
+		g.insert_edge(3, 3, 1);
+		g.erase_node(2);
+		g.insert_node(4);
+		g.insert_edge(4, 1, 7);
+		g.insert_edge(1, 4, 7);
+
+		auto g_copy = g;
+		REQUIRE(g_copy == g);
+		REQUIRE(&*g_copy.connections_view(1).begin() != &*g.connections_view(1).begin());
+		REQUIRE(g_copy.out_degree(1) == 1);
+		REQUIRE(g_copy.in_degree(1) == 1);
+
+		g.replace_node(1, 5);
+		g.erase_edge(3, 3, 1);
+		REQUIRE(g_copy.is_connected(1, 4));
+		REQUIRE(g_copy.is_connected(3, 3));
+		REQUIRE(g_copy.connections(4) == std::vector<int>{1});
+
+		g_copy.erase_node(4);
+		g_copy.insert_edge(3, 1);
+		REQUIRE(g_copy.nodes() == std::vector<int>{1, 3});
+		REQUIRE(g_copy.connections(3) == std::vector<int>{1, 3});
+		REQUIRE(g.connections(4) == std::vector<int>{5});
+	}
+
 	SECTION("Test move constructor") {
 		auto g_move = std::move(g);
 
@@ -114,6 +147,111 @@ TEST_CASE("Test graph copy and move assignment operators") {
 	}
 }
 
+TEST_CASE("snapshot() shares the graph until either side changes", "[graph][snapshot]") {
+	auto g = gdwg::test::sample_graph();
+	auto const expected = g;
+	auto const snapshot = g.snapshot();
+	REQUIRE(snapshot == expected);
+	REQUIRE(&*snapshot.connections_view("A").begin() == &*g.connections_view("A").begin());
+
+	SECTION("Changes to the graph leave the snapshot as it was") {
+		g.insert_node("E");
+		g.insert_edge("D", "A", 4);
+		g.insert_edge("A", "B", 2);
+		g.erase_edge("A", "B", 1);
+		g.erase_edge(g.find("A", "C", 2));
+		g.replace_node("C", "F");
+		g.merge_replace_node("A", "B");
+		g.erase_node("D");
+
+		REQUIRE(snapshot == expected);
+		REQUIRE(edge_list(snapshot) == edge_list(expected));
+		REQUIRE(snapshot.nodes() == std::vector<std::string>{"A", "B", "C", "D"});
+		REQUIRE(snapshot.out_degree("A") == 4);
+		REQUIRE(snapshot.in_degree("B") == 3);
+		auto const hash = std::hash<gdwg::graph<std::string, int>>{};
+		REQUIRE(hash(snapshot) == hash(expected));
+		REQUIRE(g.nodes() == std::vector<std::string>{"B", "E", "F"});
+		REQUIRE(g.connections("B") == std::vector<std::string>{"B", "B", "B"});
+		REQUIRE(g.connections("F") == std::vector<std::string>{"B", "F"});
+	}
+
+	SECTION("Changes to the snapshot leave the graph as it was") {
+		auto copy = snapshot;
+		auto changed = copy.snapshot();
+		changed.erase_edge(changed.begin(), changed.end());
+		changed.insert_edge("D", "D", 1);
+
+		REQUIRE(g == expected);
+		REQUIRE(copy == expected);
+		REQUIRE(edge_list(changed) == std::vector<std::tuple<std::string, std::string, std::optional<int>>>{
+		                                  {"D", "D", 1},
+		                              });
+		REQUIRE(changed.out_degree("D") == 1);
+		REQUIRE(changed.in_degree("A") == 0);
+	}
+
+	SECTION("The snapshot outlives the graph") {
+		g.clear();
+		g = gdwg::graph<std::string, int>{};
+		REQUIRE(snapshot == expected);
+		REQUIRE(edge_list(snapshot) == edge_list(expected));
+	}
+
+	SECTION("Erasing through an iterator into a shared block erases from the graph only") {
+		auto it = g.erase_edge(g.find("A", "B"));
+		REQUIRE(it == g.find("A", "B", 1));
+		it = g.erase_edge(g.find("A", "C", 2), g.end());
+		REQUIRE(it == g.end());
+		REQUIRE(edge_list(g) == std::vector<std::tuple<std::string, std::string, std::optional<int>>>{
+		                            {"A", "B", 1},
+		                            {"A", "B", 3},
+		                        });
+		REQUIRE(snapshot == expected);
+	}
+}
+
+TEST_CASE("Snapshots of a large graph stay as they were taken", "[graph][snapshot]") {
+	// Enough nodes to span many chunks of node slots, source ids and id shards.
+	auto const num_nodes = 10'000;
+	auto g = gdwg::graph<int, int>{};
+	for (auto n = 0; n < num_nodes; ++n) {
+		g.insert_node(n * 7 % num_nodes);
+	}
+
+	auto rng = std::mt19937{19};
+	auto node = std::uniform_int_distribution<int>{0, num_nodes - 1};
+	auto weight = std::uniform_int_distribution<int>{0, 3};
+	auto taken = std::vector<std::pair<gdwg::graph<int, int>, gdwg::graph<int, int>>>{};
+	for (auto step = 0; step < 60'000; ++step) {
+		if (step % 10'000 == 0) {
+			taken.emplace_back(g.snapshot(), g);
+		}
+		auto const src = node(rng);
+		auto const dst = node(rng);
+		// Replaced nodes take values past num_nodes, so some picks name no node.
+		if (not g.is_node(src) or not g.is_node(dst)) {
+			continue;
+		}
+		switch (step % 8) {
+		case 5: g.erase_edge(src, dst, weight(rng)); break;
+		case 6: g.replace_node(src, num_nodes + src); break;
+		case 7:
+			g.erase_node(src);
+			g.insert_node(src);
+			break;
+		default: g.insert_edge(src, dst, weight(rng));
+		}
+	}
+
+	for (auto const& [snapshot, expected] : taken) {
+		REQUIRE(snapshot == expected);
+		REQUIRE(std::ranges::equal(snapshot.nodes(), expected.nodes()));
+		REQUIRE(edge_list(snapshot) == edge_list(expected));
+	}
+	REQUIRE(edge_list(g.snapshot()) == edge_list(g));
+}
+
 TEST_CASE("Insert nodes") {
 	auto g = gdwg::graph<std::string, int>{};
 	REQUIRE(g.insert_node("A") == true);
@@ -121,6 +259,34 @@ TEST_CASE("Insert nodes") {
 	REQUIRE(g.insert_node("A") == false);
 }
 
+TEST_CASE("insert_nodes() function tests", "[graph][insert_nodes]") {
+	SECTION("Counts only nodes that were not already present") {
+		auto g = gdwg::graph<std::string, int>{"B"};
+		auto const batch = std::vector<std::string>{"C", "A", "B", "C", "D"};
+
+		REQUIRE(g.insert_nodes(batch.begin(), batch.end()) == 3);
+		REQUIRE(g.nodes() == std::vector<std::string>{"A", "B", "C", "D"});
+	}
+
+	SECTION("Accepts single-pass input ranges") {
+		auto in = std::istringstream("3 1 2 1");
+		auto g = gdwg::graph<int, int>{};
+
+		REQUIRE(g.insert_nodes(std::istream_iterator<int>(in), std::istream_iterator<int>()) == 3);
+		REQUIRE(g.nodes() == std::vector<int>{1, 2, 3});
+	}
+
+	SECTION("Existing edges are untouched") {
+		auto g = gdwg::graph<int, int>{1, 2};
+		g.insert_edge(1, 2, 5);
+		auto const batch = std::vector<int>{2, 3};
+
+		REQUIRE(g.insert_nodes(batch.begin(), batch.end()) == 1);
+		REQUIRE(g.find(1, 2, 5) != g.end());
+		REQUIRE(g.connections(3).empty());
+	}
+}
+
 TEST_CASE("Insert edges") {
 	auto g = gdwg::graph<std::string, int>{"A", "B"};
 
@@ -129,6 +295,197 @@ TEST_CASE("Insert edges") {
 	REQUIRE(g.insert_edge("A", "B", 5) == false);
 }
 
+TEST_CASE("Insert duplicate unweighted edge") {
+	auto g = gdwg::graph<std::string, int>{"A", "B"};
+
+	REQUIRE(g.insert_edge("A", "B") == true);
+	REQUIRE(g.insert_edge("A", "B") == false);
+	REQUIRE(g.edges("A", "B").size() == 1);
+}
+
+TEST_CASE("Lookups stay consistent with the edge set after mutations", "[graph][find]") {
+	auto g = gdwg::graph<int, int>{1, 2, 3, 4};
+	g.insert_edge(1, 2, 5);
+	g.insert_edge(1, 2);
+	g.insert_edge(1, 2, 3);
+	g.insert_edge(1, 3, 1);
+	g.insert_edge(2, 1, 4);
+
+	SECTION("find() reaches every edge of a multi-edge run") {
+		REQUIRE((*g.find(1, 2)).weight == std::nullopt);
+		REQUIRE((*g.find(1, 2, 3)).weight == 3);
+		REQUIRE((*g.find(1, 2, 5)).weight == 5);
+		REQUIRE(g.find(1, 2, 4) == g.end());
+		REQUIRE(g.find(3, 1) == g.end());
+	}
+
+	SECTION("Erasing the first edge of a run keeps the rest reachable") {
+		REQUIRE(g.erase_edge(1, 2) == true);
+		REQUIRE(g.is_connected(1, 2));
+		REQUIRE(g.edges(1, 2).size() == 2);
+		REQUIRE(g.erase_edge(g.find(1, 2, 3)) == g.find(1, 2, 5));
+		REQUIRE(g.erase_edge(1, 2, 5) == true);
+		REQUIRE_FALSE(g.is_connected(1, 2));
+		REQUIRE(g.edges(1, 2).empty());
+	}
+
+	SECTION("Replacing and erasing nodes updates the index") {
+		REQUIRE(g.replace_node(1, 9));
+		REQUIRE(g.is_connected(9, 2));
+		REQUIRE(g.is_connected(2, 9));
+		REQUIRE(g.edges(9, 2).size() == 3);
+		REQUIRE(g.connections(9) == std::vector<int>{2, 2, 2, 3});
+
+		g.erase_node(2);
+		REQUIRE(g.connections(9) == std::vector<int>{3});
+		REQUIRE(g.find(9, 2, 5) == g.end());
+	}
+
+	SECTION("Copies own an independent index") {
+		auto copy = g;
+		g.erase_edge(1, 3, 1);
+		REQUIRE_FALSE(g.is_connected(1, 3));
+		REQUIRE(copy.is_connected(1, 3));
+		REQUIRE((*copy.find(1, 3, 1)).to == 3);
+	}
+}
+
+TEST_CASE("Lookups in a long run of weights between one pair of nodes", "[graph][find]") {
+	constexpr auto run_length = 200;
+	auto g = gdwg::graph<int, int>{1, 2, 3};
+	g.insert_edge(1, 3, 0);
+	// Weights arrive out of order, so edges are inserted all over the run.
+	for (auto i = 0; i < run_length; ++i) {
+		REQUIRE(g.insert_edge(1, 2, i * 37 % run_length));
+	}
+	REQUIRE(g.insert_edge(1, 2));
+
+	SECTION("Every weight is found, and no other") {
+		for (auto w = 0; w < run_length; ++w) {
+			REQUIRE((*g.find(1, 2, w)).weight == w);
+			REQUIRE_FALSE(g.insert_edge(1, 2, w));
+		}
+		REQUIRE((*g.find(1, 2)).weight == std::nullopt);
+		REQUIRE(g.find(1, 2, run_length) == g.end());
+		REQUIRE(g.find(1, 2, -1) == g.end());
+	}
+
+	SECTION("The run stays in weight order") {
+		auto const edges = g.edges(1, 2);
+		REQUIRE(edges.size() == run_length + 1);
+		REQUIRE_FALSE(edges.front()->is_weighted());
+		for (auto w = 0; w < run_length; ++w) {
+			REQUIRE(edges[static_cast<std::size_t>(w) + 1]->get_weight() == w);
+		}
+	}
+
+	SECTION("Erasing from the middle of the run") {
+		for (auto w = 0; w < run_length; w += 2) {
+			REQUIRE(g.erase_edge(1, 2, w));
+			REQUIRE_FALSE(g.erase_edge(1, 2, w));
+		}
+		REQUIRE(g.edges(1, 2).size() == run_length / 2 + 1);
+		REQUIRE(g.find(1, 2, 4) == g.end());
+		REQUIRE((*g.find(1, 2, 5)).weight == 5);
+		REQUIRE((*std::next(g.find(1, 2, 199))).to == 3);
+	}
+}
+
+TEST_CASE("insert_edges() function tests", "[graph][insert_edges]") {
+	using graph = gdwg::graph<std::string, int>;
+	using edge_tuple = std::tuple<std::string, std::string, std::optional<int>>;
+
+	SECTION("Inserts a batch into an empty graph in edge order") {
+		auto g = graph{"A", "B", "C"};
+		auto const batch = std::vector<edge_tuple>{
+		    {"C", "A", 2},
+		    {"A", "B", 3},
+		    {"A", "B", std::nullopt},
+		    {"A", "B", 1},
+		    {"B", "C", 4},
+		};
+
+		REQUIRE(g.insert_edges(batch.begin(), batch.end()) == 5);
+
+		auto expected = std::vector<edge_tuple>{
+		    {"A", "B", std::nullopt},
+		    {"A", "B", 1},
+		    {"A", "B", 3},
+		    {"B", "C", 4},
+		    {"C", "A", 2},
+		};
+		auto actual = std::vector<edge_tuple>{};
+		for (auto const& [from, to, weight] : g) {
+			actual.emplace_back(from, to, weight);
+		}
+		REQUIRE(actual == expected);
+		REQUIRE(g.find("A", "B", 1) != g.end());
+		REQUIRE(g.connections("A") == std::vector<std::string>{"B", "B", "B"});
+	}
+
+	SECTION("Skips edges that repeat within the batch or already exist") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("B", "A");
+		auto const batch = std::vector<edge_tuple>{
+		    {"A", "B", 1},
+		    {"A", "B", 2},
+		    {"A", "B", 2},
+		    {"B", "A", std::nullopt},
+		    {"B", "B", std::nullopt},
+		};
+
+		REQUIRE(g.insert_edges(batch.begin(), batch.end()) == 2);
+		REQUIRE(g.edges("A", "B").size() == 2);
+		REQUIRE(g.edges("B", "A").size() == 1);
+		REQUIRE(g.is_connected("B", "B"));
+	}
+
+	SECTION("Orders a batch smaller than the graph by node value") {
+		auto g = graph{"A", "B", "C", "D", "E", "F"};
+		g.insert_edge("E", "A", 1);
+		auto const batch = std::vector<edge_tuple>{{"F", "A", 1}, {"B", "F", std::nullopt}, {"B", "C", 2}};
+
+		REQUIRE(g.insert_edges(batch.begin(), batch.end()) == 3);
+		auto actual = std::vector<edge_tuple>{};
+		for (auto const& [from, to, weight] : g) {
+			actual.emplace_back(from, to, weight);
+		}
+		REQUIRE(actual
+		        == std::vector<edge_tuple>{{"B", "C", 2}, {"B", "F", std::nullopt}, {"E", "A", 1}, {"F", "A", 1}});
+	}
+
+	SECTION("Sorts under an execution policy") {
+		auto g = graph{"A", "B", "C"};
+		auto const batch = std::vector<edge_tuple>{
+		    {"C", "A", 2},
+		    {"A", "B", 3},
+		    {"A", "B", std::nullopt},
+		    {"A", "B", 3},
+		    {"B", "C", 4},
+		};
+
+		REQUIRE(g.insert_edges(std::execution::par, batch.begin(), batch.end()) == 4);
+		auto expected = graph{"A", "B", "C"};
+		expected.insert_edges(batch.begin(), batch.end());
+		REQUIRE(g == expected);
+
+		auto const small = std::vector<edge_tuple>{{"C", "C", 1}, {"B", "A", 1}};
+		REQUIRE(g.insert_edges(std::execution::par, small.begin(), small.end()) == 2);
+		REQUIRE(g.is_connected("B", "A"));
+		REQUIRE(g.is_connected("C", "C"));
+	}
+
+	SECTION("Rejects the whole batch when a node does not exist") {
+		auto g = graph{"A", "B"};
+		auto const batch = std::vector<edge_tuple>{{"A", "B", 1}, {"A", "X", 2}};
+
+		REQUIRE_THROWS_WITH(g.insert_edges(batch.begin(), batch.end()),
+		                    "Cannot call gdwg::graph<N, E>::insert_edges when either src or dst node does not exist");
+		REQUIRE_FALSE(g.is_connected("A", "B"));
+	}
+}
+
 TEST_CASE("Insert edge with non-existent nodes throws runtime_error") {
 	auto g = gdwg::graph<std::string, int>{"A", "B"};
 
@@ -163,6 +520,40 @@ TEST_CASE("replace existing node and update edges") {
 	REQUIRE(g.is_connected(4, 3) == true);
 }
 
+TEST_CASE("replace_node reorders edges around the new value") {
+	auto g = gdwg::graph<int, int>{1, 2, 3};
+	g.insert_edge(1, 2, 7);
+	g.insert_edge(3, 1);
+	g.insert_edge(1, 1, 2);
+
+	REQUIRE(g.replace_node(1, 4));
+
+	auto it = g.begin();
+	REQUIRE((*it).from == 3);
+	REQUIRE((*it).to == 4);
+	++it;
+	REQUIRE((*it).from == 4);
+	REQUIRE((*it).to == 2);
+	++it;
+	REQUIRE((*it).from == 4);
+	REQUIRE((*it).to == 4);
+	REQUIRE(++it == g.end());
+	REQUIRE(g.find(4, 4, 2) != g.end());
+}
+
+TEST_CASE("replace_node on a copy leaves the original untouched") {
+	auto g = gdwg::graph<std::string, int>{"A", "B"};
+	g.insert_edge("A", "B", 1);
+
+	auto copy = g;
+	REQUIRE(copy.replace_node("A", "C"));
+
+	REQUIRE(g.is_node("A"));
+	REQUIRE_FALSE(g.is_node("C"));
+	REQUIRE(g.is_connected("A", "B"));
+	REQUIRE(copy.is_connected("C", "B"));
+}
+
 TEST_CASE("replace node with existing node") {
 	auto g = gdwg::graph<int, std::string>{1, 2, 3};
 
@@ -219,6 +610,56 @@ TEST_CASE("merge_replace_node: no duplicate edges") {
 	REQUIRE(edges[1]->get_weight().value() == 2);
 }
 
+TEST_CASE("merge_replace_node: edges collapsing onto the same self-loop") {
+	auto g = gdwg::graph<std::string, int>{"A", "D"};
+
+	g.insert_edge("A", "D", 1);
+	g.insert_edge("D", "A", 1);
+	g.insert_edge("A", "A");
+
+	g.merge_replace_node("A", "D");
+
+	auto edges = g.edges("D", "D");
+	REQUIRE(edges.size() == 2);
+	REQUIRE_FALSE(edges[0]->is_weighted());
+	REQUIRE(edges[1]->get_weight() == 1);
+}
+
+TEST_CASE("merge_replace_node: interleaving weights with an existing run") {
+	auto g = gdwg::graph<std::string, int>{"A", "B", "C"};
+
+	g.insert_edge("A", "C", 1);
+	g.insert_edge("A", "C", 3);
+	g.insert_edge("A", "C", 5);
+	g.insert_edge("B", "C", 2);
+	g.insert_edge("B", "C", 3);
+	g.insert_edge("B", "C", 6);
+	g.insert_edge("C", "A");
+
+	g.merge_replace_node("A", "B");
+
+	auto weights = std::vector<std::optional<int>>{};
+	for (auto const& edge : g.edges("B", "C")) {
+		weights.push_back(edge->get_weight());
+	}
+	REQUIRE(weights == std::vector<std::optional<int>>{1, 2, 3, 5, 6});
+	REQUIRE(g.connections("C") == std::vector<std::string>{"B"});
+	REQUIRE(g.find("B", "C", 5) != g.end());
+	REQUIRE(std::next(g.find("B", "C", 6)) == g.find("C", "B"));
+}
+
+TEST_CASE("merge_replace_node: merging a node into itself changes nothing") {
+	auto g = gdwg::graph<std::string, int>{"A", "B"};
+	g.insert_edge("A", "B", 1);
+	g.insert_edge("B", "A", 2);
+
+	g.merge_replace_node("A", "A");
+
+	REQUIRE(g.nodes() == std::vector<std::string>{"A", "B"});
+	REQUIRE(g.is_connected("A", "B"));
+	REQUIRE(g.is_connected("B", "A"));
+}
+
 TEST_CASE("erase_node() function tests", "[graph][erase_node]") {
 	using graph = gdwg::graph<std::string, int>;
 
@@ -244,6 +685,51 @@ TEST_CASE("erase_node() function tests", "[graph][erase_node]") {
 
 		REQUIRE(result == expected);
 	}
+
+	SECTION("Erase a node with self-loops and parallel incoming edges") {
+		auto g = graph{"A", "B", "C"};
+
+		g.insert_edge("B", "B", 1);
+		g.insert_edge("B", "B");
+		g.insert_edge("A", "B", 2);
+		g.insert_edge("A", "B", 3);
+		g.insert_edge("C", "B");
+		g.insert_edge("B", "A", 4);
+		g.insert_edge("A", "C", 5);
+
+		REQUIRE(g.erase_node("B") == true);
+
+		auto expected = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{{"A", "C", 5}};
+		auto actual = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{};
+		for (auto const& [from, to, weight] : g) {
+			actual.emplace_back(from, to, weight);
+		}
+		REQUIRE(actual == expected);
+		REQUIRE(g.connections("C").empty());
+
+		REQUIRE(g.insert_node("B"));
+		REQUIRE(g.insert_edge("C", "B"));
+		REQUIRE(g.edges("C", "B").size() == 1);
+	}
+}
+
+TEST_CASE("Nodes inserted after an erase do not inherit its edges", "[graph][erase_node]") {
+	auto g = gdwg::graph<std::string, int>{"A", "B", "C"};
+	g.insert_edge("A", "B", 1);
+	g.insert_edge("B", "C", 2);
+
+	REQUIRE(g.erase_node("B"));
+	REQUIRE(g.insert_node("D"));
+	REQUIRE(g.insert_node("B"));
+
+	REQUIRE(g.connections("A").empty());
+	REQUIRE(g.connections("B").empty());
+	REQUIRE(g.connections("D").empty());
+	REQUIRE(g.nodes() == std::vector<std::string>{"A", "B", "C", "D"});
+
+	REQUIRE(g.insert_edge("D", "A", 3));
+	REQUIRE(g.is_connected("D", "A"));
+	REQUIRE_FALSE(g.is_connected("B", "A"));
 }
 
 TEST_CASE("Erase a weighted edge that exists") {
@@ -455,6 +941,85 @@ TEST_CASE("connections() function tests", "[graph][connections]") {
 	}
 }
 
+TEST_CASE("connections_view() function tests", "[graph][connections_view]") {
+	using graph = gdwg::graph<std::string, int>;
+
+	SECTION("Destinations are sorted and appear once each") {
+		auto g = graph{"A", "B", "C", "D"};
+		g.insert_edge("A", "D", 3);
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("A", "B");
+		g.insert_edge("A", "B", 2);
+		g.insert_edge("A", "A", 4);
+		g.insert_edge("B", "C", 5);
+		g.insert_edge("C", "A", 6);
+
+		auto const view = g.connections_view("A");
+		REQUIRE(std::vector<std::string>(view.begin(), view.end()) == std::vector<std::string>{"A", "B", "D"});
+		REQUIRE(std::ranges::equal(g.connections_view("B"), std::vector<std::string>{"C"}));
+	}
+
+	SECTION("A node without outgoing edges has an empty view") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+
+		REQUIRE(g.connections_view("B").empty());
+	}
+
+	SECTION("Refers to the graph's nodes") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+
+		REQUIRE(&*g.connections_view("A").begin() == &(*g.edges_view("A", "B").begin()).to);
+	}
+
+	SECTION("Throws when the node does not exist") {
+		auto g = graph{"A"};
+		REQUIRE_THROWS_WITH(g.connections_view("B"),
+		                    "Cannot call gdwg::graph<N, E>::connections_view if src doesn't exist in the graph");
+	}
+}
+
+TEST_CASE("out_degree() and in_degree() function tests", "[graph][degree]") {
+	using graph = gdwg::graph<std::string, int>;
+	auto g = graph{"A", "B", "C"};
+	g.insert_edge("A", "B", 1);
+	g.insert_edge("A", "B", 2);
+	g.insert_edge("A", "A");
+	g.insert_edge("C", "A", 3);
+
+	SECTION("Count edges, not neighbours") {
+		REQUIRE(g.out_degree("A") == 3);
+		REQUIRE(g.in_degree("A") == 2);
+		REQUIRE(g.in_degree("B") == 2);
+		REQUIRE(g.out_degree("B") == 0);
+	}
+
+	SECTION("Follow edge and node mutations") {
+		g.erase_edge("A", "B", 1);
+		REQUIRE(g.out_degree("A") == 2);
+		REQUIRE(g.in_degree("B") == 1);
+
+		g.erase_node("C");
+		REQUIRE(g.in_degree("A") == 1);
+
+		g.replace_node("A", "D");
+		REQUIRE(g.out_degree("D") == 2);
+		REQUIRE(g.in_degree("D") == 1);
+
+		g.merge_replace_node("B", "D");
+		REQUIRE(g.out_degree("D") == 2);
+		REQUIRE(g.in_degree("D") == 2);
+	}
+
+	SECTION("Throw when the node does not exist") {
+		REQUIRE_THROWS_WITH(g.out_degree("X"),
+		                    "Cannot call gdwg::graph<N, E>::out_degree if the node doesn't exist in the graph");
+		REQUIRE_THROWS_WITH(g.in_degree("X"),
+		                    "Cannot call gdwg::graph<N, E>::in_degree if the node doesn't exist in the graph");
+	}
+}
+
 TEST_CASE("Nodes function returns all stored nodes sorted in ascending order", "[graph][nodes]") {
 	using graph = gdwg::graph<std::string, int>;
 
@@ -568,6 +1133,65 @@ TEST_CASE("edges function tests", "[graph][edges]") {
 	}
 }
 
+TEST_CASE("edges_view function tests", "[graph][edges_view]") {
+	using graph = gdwg::graph<std::string, int>;
+
+	SECTION("Views the same edges as edges(), in the same order") {
+		auto g = graph{"A", "B", "C"};
+		g.insert_edge("A", "B", 5);
+		g.insert_edge("A", "B");
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("A", "C", 2);
+		g.insert_edge("B", "A", 3);
+
+		auto weights = std::vector<std::optional<int>>{};
+		for (auto const& [from, to, weight] : g.edges_view("A", "B")) {
+			REQUIRE(from == "A");
+			REQUIRE(to == "B");
+			weights.push_back(weight != nullptr ? std::optional<int>(*weight) : std::nullopt);
+		}
+		REQUIRE(weights == std::vector<std::optional<int>>{std::nullopt, 1, 5});
+	}
+
+	SECTION("Ends with the run, before the next source's edges") {
+		auto g = graph{"A", "B", "C"};
+		g.insert_edge("A", "C", 2);
+		g.insert_edge("A", "C", 4);
+		g.insert_edge("B", "A", 3);
+		g.insert_edge("A", "A", 1);
+
+		auto const view = g.edges_view("A", "C");
+		REQUIRE(std::ranges::distance(view) == 2);
+		REQUIRE(*(*std::ranges::next(view.begin())).weight == 4);
+		REQUIRE(std::ranges::distance(g.edges_view("B", "A")) == 1);
+	}
+
+	SECTION("Refers into the graph instead of copying") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+
+		auto const first = *g.edges_view("A", "B").begin();
+		auto const second = *g.edges_view("A", "B").begin();
+		REQUIRE(&first.from == &second.from);
+		REQUIRE(first.weight == second.weight);
+		REQUIRE(*first.weight == 1);
+	}
+
+	SECTION("Is empty when the nodes are not connected") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("B", "A", 1);
+
+		REQUIRE(g.edges_view("A", "B").empty());
+	}
+
+	SECTION("Throws when either node does not exist") {
+		auto g = graph{"A"};
+
+		REQUIRE_THROWS_WITH(g.edges_view("A", "X"),
+		                    "Cannot call gdwg::graph<N, E>::edges_view if src or dst node don't exist in the graph");
+	}
+}
+
 TEST_CASE("Test equality operator for gdwg::graph", "[graph][operator==]") {
 	using graph = gdwg::graph<std::string, int>;
 
@@ -636,6 +1260,135 @@ TEST_CASE("Test equality operator for gdwg::graph", "[graph][operator==]") {
 
 		REQUIRE(g1 == g2);
 	}
+
+	SECTION("Test equality operator ignores insertion order") {
+		auto g1 = graph{"C", "A", "B"};
+		g1.insert_edge("C", "A");
+		g1.insert_edge("A", "B", 2);
+		g1.insert_edge("A", "B", 1);
+
+		auto g2 = graph{"A", "B", "C"};
+		g2.insert_edge("A", "B", 1);
+		g2.insert_edge("C", "A");
+		g2.insert_edge("A", "B", 2);
+
+		REQUIRE(g1 == g2);
+		REQUIRE(g2 == g1);
+	}
+
+	SECTION("Test equality operator for graphs differing in one edge's weight") {
+		auto g1 = graph{"A", "B", "C"};
+		g1.insert_edge("A", "B", 1);
+		g1.insert_edge("B", "C", 2);
+		g1.insert_edge("C", "A");
+
+		auto g2 = graph{"A", "B", "C"};
+		g2.insert_edge("A", "B", 1);
+		g2.insert_edge("B", "C", 2);
+		g2.insert_edge("C", "A", 3);
+
+		REQUIRE_FALSE(g1 == g2);
+		REQUIRE_FALSE(g2 == g1);
+	}
+}
+
+TEST_CASE("std::hash for gdwg::graph", "[graph][hash]") {
+	using graph = gdwg::graph<std::string, int>;
+	auto const hash = std::hash<graph>{};
+
+	// The same graph built from scratch, in iteration order.
+	auto const rebuilt = [](graph const& g) {
+		auto const nodes = g.nodes();
+		auto result = graph(nodes.begin(), nodes.end());
+		for (auto const& [from, to, weight] : g) {
+			result.insert_edge(from, to, weight);
+		}
+		return result;
+	};
+
+	SECTION("Equal graphs hash equally whatever their insertion order") {
+		auto g1 = graph{"C", "A", "B"};
+		g1.insert_edge("C", "A");
+		g1.insert_edge("A", "B", 2);
+		g1.insert_edge("A", "B", 1);
+
+		auto g2 = graph{"A", "B", "C"};
+		g2.insert_edge("A", "B", 1);
+		g2.insert_edge("C", "A");
+		g2.insert_edge("A", "B", 2);
+
+		REQUIRE(hash(g1) == hash(g2));
+	}
+
+	SECTION("Hashes differ for graphs that differ in one edge") {
+		auto g1 = graph{"A", "B"};
+		g1.insert_edge("A", "B", 1);
+		auto g2 = graph{"A", "B"};
+		g2.insert_edge("B", "A", 1);
+		auto g3 = graph{"A", "B"};
+		g3.insert_edge("A", "B");
+
+		REQUIRE(hash(g1) != hash(g2));
+		REQUIRE(hash(g1) != hash(g3));
+		REQUIRE(hash(g1) != hash(graph{"A", "B"}));
+	}
+
+	SECTION("Inserting and erasing restores the hash") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+		auto const before = hash(g);
+
+		g.insert_node("C");
+		g.insert_edge("C", "A", 4);
+		g.insert_edge("A", "A");
+		REQUIRE(hash(g) != before);
+
+		g.erase_edge("A", "A");
+		g.erase_node("C");
+		REQUIRE(hash(g) == before);
+	}
+
+	SECTION("Tracks replace_node, merge_replace_node and erase_node") {
+		auto g = graph{"A", "B", "C", "D"};
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("A", "C", 2);
+		g.insert_edge("B", "B", 3);
+		g.insert_edge("C", "A");
+		g.insert_edge("D", "B", 1);
+
+		g.replace_node("B", "E");
+		REQUIRE(hash(g) == hash(rebuilt(g)));
+		g.merge_replace_node("A", "D");
+		REQUIRE(hash(g) == hash(rebuilt(g)));
+		g.erase_node("E");
+		REQUIRE(hash(g) == hash(rebuilt(g)));
+		g.erase_edge(g.begin(), g.end());
+		REQUIRE(hash(g) == hash(graph{"C", "D"}));
+	}
+
+	SECTION("Copies share the hash, and a moved-from or cleared graph hashes like an empty one") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+
+		auto copy = g;
+		REQUIRE(hash(copy) == hash(g));
+
+		auto moved = std::move(copy);
+		REQUIRE(hash(moved) == hash(g));
+		REQUIRE(hash(copy) == hash(graph{}));
+
+		g.clear();
+		REQUIRE(hash(g) == hash(graph{}));
+	}
+
+	SECTION("Graphs can key an unordered_set") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+
+		auto seen = std::unordered_set<graph>{g, rebuilt(g), graph{"A"}};
+		REQUIRE(seen.size() == 2);
+		REQUIRE(seen.contains(g));
+	}
 }
 
 TEST_CASE("Testing operator<< for graph output") {
@@ -699,6 +1452,32 @@ TEST_CASE("Testing operator<< for graph output") {
 	CHECK(out.str() == expected_output);
 }
 
+TEST_CASE("operator<< lists each node's edges in string order", "[graph][operator<<]") {
+	auto g = gdwg::graph<int, int>{1, 9, 10};
+	g.insert_edge(1, 9, 10);
+	g.insert_edge(1, 9, 9);
+	g.insert_edge(1, 9, -4);
+	g.insert_edge(1, 9, -1);
+	g.insert_edge(1, 10);
+
+	auto out = std::ostringstream{};
+	out << g;
+	auto const expected_output = std::string_view(R"(
+1 (
+  1 -> 10 | U
+  1 -> 9 | W | -1
+  1 -> 9 | W | -4
+  1 -> 9 | W | 10
+  1 -> 9 | W | 9
+)
+9 (
+)
+10 (
+)
+)");
+	CHECK(out.str() == expected_output);
+}
+
 TEST_CASE("begin() and end() function tests") {
 	auto g = gdwg::graph<std::string, int>{"A", "B", "C"};
 
@@ -810,6 +1589,48 @@ TEST_CASE("Graph iterator tests", "[graph][iterator]") {
 	}
 }
 
+TEST_CASE("edge_refs function tests", "[graph][edge_refs]") {
+	using graph = gdwg::graph<std::string, int>;
+
+	SECTION("Visits the same edges as the graph iterator, in the same order") {
+		auto g = graph{"A", "B", "C"};
+		g.insert_edge("B", "C", 2);
+		g.insert_edge("A", "B");
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("C", "A", 3);
+
+		auto expected = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{};
+		for (auto const& [from, to, weight] : g) {
+			expected.emplace_back(from, to, weight);
+		}
+
+		auto actual = std::vector<std::tuple<std::string, std::string, std::optional<int>>>{};
+		for (auto const& [from, to, weight] : g.edge_refs()) {
+			actual.emplace_back(from, to, weight != nullptr ? std::optional<int>(*weight) : std::nullopt);
+		}
+		REQUIRE(actual == expected);
+	}
+
+	SECTION("Refers into the graph instead of copying") {
+		auto g = graph{"A", "B"};
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("B", "A", 2);
+
+		auto const edges = g.edge_refs();
+		auto const first = *edges.begin();
+		auto const second = *std::next(edges.begin());
+		REQUIRE(&first.from == &second.to);
+		REQUIRE(&first.to == &second.from);
+		REQUIRE(first.weight == (*g.edges_view("A", "B").begin()).weight);
+	}
+
+	SECTION("Is empty for a graph without edges") {
+		auto g = graph{"A", "B"};
+
+		REQUIRE(g.edge_refs().empty());
+	}
+}
+
 TEST_CASE("Test graph const correctness") {
 	auto g = gdwg::graph<int, int>{1, 2, 3};
 
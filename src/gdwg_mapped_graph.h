@@ -0,0 +1,451 @@
+#ifndef GDWG_MAPPED_GRAPH_H
+#define GDWG_MAPPED_GRAPH_H
+
+#include "gdwg_binary.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gdwg {
+	// A read-only graph served straight from a file written by save_binary(). The file is mapped into memory and
+	// every query reads the mapped sections in place, in the same way frozen_graph reads its arrays.
+	//
+	// Opening a file checks its header and section bounds in O(1) and allocates nothing, however large the graph.
+	// Pages are read in as queries touch them, and processes mapping the same file share one copy in the page cache.
+	// The contents are trusted once the header checks out; call verify() first for files that might be damaged.
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	class mapped_graph {
+		// A value as it can be compared in place: a std::string is compared as a view of the string pool.
+		template<typename T>
+		using key_t = std::conditional_t<std::same_as<T, std::string>, std::string_view, T>;
+
+		template<typename T>
+		static auto key_of(T const& value) -> key_t<T> {
+			return value;
+		}
+
+		// Where each section of the mapped file starts. Records are read with binary::read(), so they need not be
+		// aligned.
+		struct sections {
+			char const* nodes = nullptr;
+			char const* offsets = nullptr;
+			char const* dsts = nullptr;
+			char const* weighted = nullptr;
+			char const* weights = nullptr;
+			char const* strings = nullptr;
+			std::uint64_t node_count = 0;
+			std::uint64_t edge_count = 0;
+
+			auto offset(std::uint64_t src) const -> std::uint64_t {
+				return binary::read<std::uint64_t>(offsets + src * sizeof(std::uint64_t));
+			}
+			auto dst(std::uint64_t i) const -> std::uint32_t {
+				return binary::read<std::uint32_t>(dsts + i * sizeof(std::uint32_t));
+			}
+			template<typename T>
+			auto key(char const* table, std::uint64_t i) const -> key_t<T> {
+				auto const stored = binary::read<binary::stored_t<T>>(table + i * sizeof(binary::stored_t<T>));
+				if constexpr (std::same_as<T, std::string>) {
+					return std::string_view(strings + stored.offset, stored.size);
+				}
+				else {
+					return stored;
+				}
+			}
+			auto node(std::uint64_t id) const -> N {
+				return N(key<N>(nodes, id));
+			}
+			auto weight_key(std::uint64_t i) const -> std::optional<key_t<E>> {
+				return weighted[i] != 0 ? std::optional<key_t<E>>(key<E>(weights, i)) : std::nullopt;
+			}
+			auto weight(std::uint64_t i) const -> std::optional<E> {
+				return weighted[i] != 0 ? std::optional<E>(E(key<E>(weights, i))) : std::nullopt;
+			}
+		};
+
+	 public:
+		using edge = gdwg::edge<N, E>;
+		using node_id = std::uint32_t;
+
+		class iterator {
+		 public:
+			using value_type = struct {
+				N from;
+				N to;
+				std::optional<E> weight;
+			};
+			using reference = value_type;
+			using pointer = void;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::random_access_iterator_tag;
+
+			iterator() = default;
+
+			// Iterator source
+			auto operator*() const -> reference {
+				return {g_.node(src_), g_.node(g_.dst(index_)), g_.weight(index_)};
+			}
+			auto operator[](difference_type n) const -> reference {
+				return *(*this + n);
+			}
+
+			// Iterator traversal
+			auto operator++() -> iterator& {
+				++index_;
+				skip_exhausted_sources();
+				return *this;
+			}
+			auto operator++(int) -> iterator {
+				auto temp = *this;
+				++*this;
+				return temp;
+			}
+			auto operator--() -> iterator& {
+				--index_;
+				while (g_.offset(src_) > index_) {
+					--src_;
+				}
+				return *this;
+			}
+			auto operator--(int) -> iterator {
+				auto temp = *this;
+				--*this;
+				return temp;
+			}
+			auto operator+=(difference_type n) -> iterator& {
+				index_ = static_cast<std::uint64_t>(static_cast<difference_type>(index_) + n);
+				auto const sources = std::views::iota(std::uint64_t{0}, g_.node_count + 1);
+				auto const next = std::ranges::upper_bound(sources, index_, {}, [this](std::uint64_t i) {
+					return g_.offset(i);
+				});
+				src_ = *next - 1;
+				return *this;
+			}
+			auto operator-=(difference_type n) -> iterator& {
+				return *this += -n;
+			}
+			friend auto operator+(iterator it, difference_type n) -> iterator {
+				return it += n;
+			}
+			friend auto operator+(difference_type n, iterator it) -> iterator {
+				return it += n;
+			}
+			friend auto operator-(iterator it, difference_type n) -> iterator {
+				return it -= n;
+			}
+			auto operator-(iterator const& other) const -> difference_type {
+				return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+			}
+
+			// Iterator comparison
+			auto operator==(iterator const& other) const -> bool {
+				return index_ == other.index_;
+			}
+			auto operator<=>(iterator const& other) const -> std::strong_ordering {
+				return index_ <=> other.index_;
+			}
+
+		 private:
+			iterator(sections const& g, std::uint64_t src, std::uint64_t index)
+			: g_(g)
+			, src_(src)
+			, index_(index) {
+				skip_exhausted_sources();
+			}
+
+			auto skip_exhausted_sources() -> void {
+				while (src_ < g_.node_count and g_.offset(src_ + 1) <= index_) {
+					++src_;
+				}
+			}
+
+			// A copy of the section pointers rather than the mapped_graph, so moving the graph keeps them valid.
+			sections g_ = {};
+			std::uint64_t src_ = 0;
+			std::uint64_t index_ = 0;
+			friend class mapped_graph<N, E>;
+		};
+
+		explicit mapped_graph(std::filesystem::path const& path);
+		mapped_graph(mapped_graph&& other) noexcept;
+		mapped_graph(mapped_graph const& other) = delete;
+		auto operator=(mapped_graph&& other) noexcept -> mapped_graph&;
+		auto operator=(mapped_graph const& other) -> mapped_graph& = delete;
+		~mapped_graph();
+
+		auto verify() const -> void;
+
+		[[nodiscard]] auto is_node(N const& value) const -> bool;
+		[[nodiscard]] auto empty() const noexcept -> bool;
+		[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
+		[[nodiscard]] auto nodes() const -> std::vector<N>;
+		[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const -> iterator;
+		[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+
+		[[nodiscard]] auto begin() const -> iterator;
+		[[nodiscard]] auto end() const -> iterator;
+
+	 private:
+		auto find_node(N const& value) const -> std::optional<node_id>;
+		// Range of src's outgoing edges to dst, ordered by weight with the unweighted edge first.
+		auto edge_range(node_id src, node_id dst) const -> std::pair<std::uint64_t, std::uint64_t>;
+
+		char const* data_ = nullptr;
+		std::size_t size_ = 0;
+		sections sections_;
+	};
+
+	// Implementation of mapped_graph member functions
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	mapped_graph<N, E>::mapped_graph(std::filesystem::path const& path) {
+		constexpr auto caller = std::string_view("gdwg::mapped_graph<N, E>::mapped_graph");
+		auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat status = {};
+		if (fd < 0 or ::fstat(fd, &status) != 0) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+			binary::fail(caller, "a file that cannot be read");
+		}
+
+		// An empty file is not mapped at all, and is then rejected as too short by parse().
+		size_ = static_cast<std::size_t>(status.st_size);
+		auto* const mapped = size_ != 0 ? ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+		::close(fd);
+		if (mapped == MAP_FAILED) {
+			binary::fail(caller, "a file that cannot be read");
+		}
+		data_ = static_cast<char const*>(mapped);
+
+		try {
+			auto const file = binary::parse<N, E>(data_, size_, caller);
+			sections_ = {file.section_data(binary::node_section),
+			             file.section_data(binary::offset_section),
+			             file.section_data(binary::dst_section),
+			             file.section_data(binary::weighted_section),
+			             file.section_data(binary::weight_section),
+			             file.section_data(binary::string_section),
+			             file.head.node_count,
+			             file.head.edge_count};
+		} catch (...) {
+			if (data_ != nullptr) {
+				::munmap(const_cast<char*>(data_), size_);
+			}
+			throw;
+		}
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	mapped_graph<N, E>::mapped_graph(mapped_graph&& other) noexcept
+	: data_(std::exchange(other.data_, nullptr))
+	, size_(std::exchange(other.size_, 0))
+	, sections_(std::exchange(other.sections_, {})) {}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	auto mapped_graph<N, E>::operator=(mapped_graph&& other) noexcept -> mapped_graph& {
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		std::swap(sections_, other.sections_);
+		return *this;
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	mapped_graph<N, E>::~mapped_graph() {
+		if (data_ != nullptr) {
+			::munmap(const_cast<char*>(data_), size_);
+		}
+	}
+
+	// Checks every offset, destination, weight flag and string reference, that the nodes are in ascending order,
+	// and that each node's outgoing edges are in ascending (dst, weight) order with the unweighted edge first, in
+	// O(V + E) without allocating. Throws std::runtime_error if the file is damaged.
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	auto mapped_graph<N, E>::verify() const -> void {
+		constexpr auto caller = std::string_view("gdwg::mapped_graph<N, E>::verify");
+		binary::check_contents<N, E>(binary::parse<N, E>(data_, size_, caller), caller);
+		for (auto src = std::uint64_t{0}; src < sections_.node_count; ++src) {
+			if (src != 0
+			    and not(sections_.template key<N>(sections_.nodes, src - 1)
+			            < sections_.template key<N>(sections_.nodes, src)))
+			{
+				binary::fail(caller, "a corrupt binary graph");
+			}
+			// find(), edges() and is_connected() binary-search this slice, so it must be strictly ascending.
+			for (auto i = sections_.offset(src) + 1; i < sections_.offset(src + 1); ++i) {
+				auto const previous = std::pair(sections_.dst(i - 1), sections_.weight_key(i - 1));
+				if (not(previous < std::pair(sections_.dst(i), sections_.weight_key(i)))) {
+					binary::fail(caller, "a corrupt binary graph");
+				}
+			}
+		}
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	auto mapped_graph<N, E>::find_node(N const& value) const -> std::optional<node_id> {
+		auto const ids = std::views::iota(std::uint64_t{0}, sections_.node_count);
+		auto const key = key_of(value);
+		auto const it = std::ranges::lower_bound(ids, key, {}, [this](std::uint64_t id) {
+			return sections_.template key<N>(sections_.nodes, id);
+		});
+		if (it == ids.end() or sections_.template key<N>(sections_.nodes, *it) != key) {
+			return std::nullopt;
+		}
+		return static_cast<node_id>(*it);
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	auto mapped_graph<N, E>::edge_range(node_id src, node_id dst) const -> std::pair<std::uint64_t, std::uint64_t> {
+		auto const edges = std::views::iota(sections_.offset(src), sections_.offset(src + 1));
+		auto const [lower, upper] = std::ranges::equal_range(edges, dst, {}, [this](std::uint64_t i) {
+			return sections_.dst(i);
+		});
+		auto const first = sections_.offset(src);
+		return {first + static_cast<std::uint64_t>(lower - edges.begin()),
+		        first + static_cast<std::uint64_t>(upper - edges.begin())};
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::is_node(N const& value) const -> bool {
+		return find_node(value).has_value();
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::empty() const noexcept -> bool {
+		return sections_.node_count == 0;
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::is_connected(N const& src, N const& dst) const -> bool {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
+			throw std::runtime_error("Cannot call gdwg::mapped_graph<N, E>::is_connected if src or dst node don't "
+			                         "exist in the graph");
+		}
+
+		auto const [first, last] = edge_range(*src_id, *dst_id);
+		return first != last;
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::nodes() const -> std::vector<N> {
+		auto result = std::vector<N>{};
+		result.reserve(sections_.node_count);
+		for (auto id = std::uint64_t{0}; id < sections_.node_count; ++id) {
+			result.push_back(sections_.node(id));
+		}
+		return result;
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::edges(N const& src, N const& dst) const
+	    -> std::vector<std::unique_ptr<edge>> {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
+			throw std::runtime_error("Cannot call gdwg::mapped_graph<N, E>::edges if src or dst node don't exist in "
+			                         "the graph");
+		}
+
+		auto const [first, last] = edge_range(*src_id, *dst_id);
+		auto result = std::vector<std::unique_ptr<edge>>{};
+		result.reserve(last - first);
+		for (auto i = first; i != last; ++i) {
+			if (auto weight = sections_.weight(i)) {
+				result.push_back(std::make_unique<weighted_edge<N, E>>(src, dst, std::move(*weight)));
+			}
+			else {
+				result.push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+			}
+		}
+		return result;
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const
+	    -> iterator {
+		auto const src_id = find_node(src);
+		auto const dst_id = find_node(dst);
+		if (not src_id or not dst_id) {
+			return end();
+		}
+
+		// std::optional orders nullopt before every value, matching the unweighted-first edge order.
+		auto const [first, last] = edge_range(*src_id, *dst_id);
+		auto const edges = std::views::iota(first, last);
+		auto const key = weight ? std::optional<key_t<E>>(key_of(*weight)) : std::nullopt;
+		auto const it = std::ranges::lower_bound(edges, key, {}, [this](std::uint64_t i) {
+			return sections_.weight_key(i);
+		});
+		if (it == edges.end() or sections_.weight_key(*it) != key) {
+			return end();
+		}
+		return iterator(sections_, *src_id, *it);
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::connections(N const& src) const -> std::vector<N> {
+		auto const src_id = find_node(src);
+		if (not src_id) {
+			throw std::runtime_error("Cannot call gdwg::mapped_graph<N, E>::connections if src doesn't exist in the "
+			                         "graph");
+		}
+
+		auto result = std::vector<N>{};
+		result.reserve(sections_.offset(*src_id + 1) - sections_.offset(*src_id));
+		for (auto i = sections_.offset(*src_id); i != sections_.offset(*src_id + 1); ++i) {
+			result.push_back(sections_.node(sections_.dst(i)));
+		}
+		return result;
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::begin() const -> iterator {
+		return iterator(sections_, 0, 0);
+	}
+
+	template<typename N, typename E>
+	requires binary::encodable<N> and binary::encodable<E>
+	[[nodiscard]] auto mapped_graph<N, E>::end() const -> iterator {
+		return iterator(sections_, sections_.node_count, sections_.edge_count);
+	}
+
+} // namespace gdwg
+
+#endif // GDWG_MAPPED_GRAPH_H
@@ -0,0 +1,178 @@
+#include "gdwg_mapped_graph.h"
+#include "gdwg_test_helpers.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using gdwg::test::edge_list;
+using gdwg::test::sample_graph;
+using gdwg::test::temp_file;
+
+TEST_CASE("mapped_graph serves the graph saved in the file", "[mapped_graph]") {
+	auto const file = temp_file("sample");
+	auto const g = sample_graph();
+	gdwg::save_binary(g, file.path);
+	auto const mg = gdwg::mapped_graph<std::string, int>(file.path);
+	REQUIRE_NOTHROW(mg.verify());
+
+	SECTION("nodes") {
+		REQUIRE_FALSE(mg.empty());
+		REQUIRE(mg.nodes() == g.nodes());
+		REQUIRE(mg.is_node("D"));
+		REQUIRE_FALSE(mg.is_node("E"));
+		REQUIRE_FALSE(mg.is_node(""));
+	}
+
+	SECTION("iteration") {
+		REQUIRE(edge_list(mg) == edge_list(g));
+		REQUIRE(std::distance(mg.begin(), mg.end()) == 6);
+
+		auto last = mg.end();
+		--last;
+		REQUIRE((*last).from == "C");
+		REQUIRE((*last).weight == std::nullopt);
+		REQUIRE((*(mg.begin() + 4)).from == "C");
+		REQUIRE((*(mg.begin() + 4)).to == "A");
+		REQUIRE(mg.end() - 2 == mg.begin() + 4);
+		REQUIRE(mg.begin()[3].to == "C");
+	}
+
+	SECTION("is_connected") {
+		REQUIRE(mg.is_connected("A", "B"));
+		REQUIRE(mg.is_connected("C", "C"));
+		REQUIRE_FALSE(mg.is_connected("B", "A"));
+		REQUIRE_FALSE(mg.is_connected("D", "D"));
+		REQUIRE_THROWS_WITH(mg.is_connected("A", "E"),
+		                    "Cannot call gdwg::mapped_graph<N, E>::is_connected if src or dst node don't exist in the "
+		                    "graph");
+	}
+
+	SECTION("find") {
+		REQUIRE((*mg.find("A", "B")).weight == std::nullopt);
+		REQUIRE((*mg.find("A", "B", 3)).weight == 3);
+		REQUIRE(mg.find("A", "B", 2) == mg.end());
+		REQUIRE(mg.find("A", "E") == mg.end());
+		REQUIRE(std::next(mg.find("A", "B", 3)) == mg.find("A", "C", 2));
+	}
+
+	SECTION("edges") {
+		auto const edges = mg.edges("A", "B");
+		REQUIRE(edges.size() == 3);
+		REQUIRE(edges[0]->print_edge() == "A -> B | U");
+		REQUIRE(edges[1]->print_edge() == "A -> B | W | 1");
+		REQUIRE(edges[2]->print_edge() == "A -> B | W | 3");
+		REQUIRE(mg.edges("B", "A").empty());
+		REQUIRE_THROWS_WITH(mg.edges("A", "E"),
+		                    "Cannot call gdwg::mapped_graph<N, E>::edges if src or dst node don't exist in the graph");
+	}
+
+	SECTION("connections") {
+		REQUIRE(mg.connections("A") == g.connections("A"));
+		REQUIRE(mg.connections("D").empty());
+		REQUIRE_THROWS_WITH(mg.connections("E"),
+		                    "Cannot call gdwg::mapped_graph<N, E>::connections if src doesn't exist in the graph");
+	}
+}
+
+TEST_CASE("mapped_graph reads trivially copyable nodes and string weights in place", "[mapped_graph]") {
+	auto const file = temp_file("int_string");
+	auto g = gdwg::graph<int, std::string>{-3, 0, 7, 10};
+	g.insert_edge(10, -3, "b");
+	g.insert_edge(10, -3, "a");
+	g.insert_edge(10, -3);
+	g.insert_edge(7, 10, "seven");
+	gdwg::save_binary(g, file.path);
+	auto const mg = gdwg::mapped_graph<int, std::string>(file.path);
+
+	REQUIRE(mg.nodes() == g.nodes());
+	REQUIRE(edge_list(mg) == edge_list(g));
+	REQUIRE((*mg.find(10, -3, "a")).weight == "a");
+	REQUIRE(mg.find(10, -3, "c") == mg.end());
+	REQUIRE(mg.connections(10) == std::vector<int>{-3, -3, -3});
+}
+
+TEST_CASE("mapped_graph iterators stay valid when the graph is moved", "[mapped_graph]") {
+	auto const file = temp_file("moved");
+	gdwg::save_binary(sample_graph(), file.path);
+	auto mg = gdwg::mapped_graph<std::string, int>(file.path);
+	auto const it = mg.find("C", "A", 5);
+
+	auto const moved = std::move(mg);
+	REQUIRE((*it).to == "A");
+	REQUIRE(std::next(it) == moved.find("C", "C"));
+}
+
+TEST_CASE("mapped_graph of an empty graph", "[mapped_graph]") {
+	auto const file = temp_file("empty");
+	gdwg::save_binary(gdwg::graph<int, int>{}, file.path);
+	auto const mg = gdwg::mapped_graph<int, int>(file.path);
+
+	REQUIRE(mg.empty());
+	REQUIRE(mg.begin() == mg.end());
+	REQUIRE_FALSE(mg.is_node(0));
+}
+
+TEST_CASE("mapped_graph rejects files it cannot serve", "[mapped_graph]") {
+	auto const file = temp_file("rejected");
+
+	SECTION("a missing file") {
+		REQUIRE_THROWS_WITH((gdwg::mapped_graph<std::string, int>(file.path)),
+		                    "Cannot call gdwg::mapped_graph<N, E>::mapped_graph on a file that cannot be read");
+	}
+
+	SECTION("an empty file") {
+		std::ofstream(file.path).close();
+		REQUIRE_THROWS_WITH((gdwg::mapped_graph<std::string, int>(file.path)),
+		                    "Cannot call gdwg::mapped_graph<N, E>::mapped_graph on a file that is not a binary graph");
+	}
+
+	SECTION("other node or weight types") {
+		gdwg::save_binary(sample_graph(), file.path);
+		REQUIRE_THROWS_WITH((gdwg::mapped_graph<int, int>(file.path)),
+		                    "Cannot call gdwg::mapped_graph<N, E>::mapped_graph on a binary graph of other node or "
+		                    "weight types");
+	}
+
+	SECTION("damaged contents are caught by verify()") {
+		gdwg::save_binary(sample_graph(), file.path);
+		auto const head = [&file] {
+			auto in = std::ifstream(file.path, std::ios::binary);
+			auto bytes = std::vector<char>(sizeof(gdwg::binary::header));
+			in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+			return gdwg::binary::read<gdwg::binary::header>(bytes.data());
+		}();
+		{
+			auto out = std::fstream(file.path, std::ios::binary | std::ios::in | std::ios::out);
+			out.seekp(static_cast<std::streamoff>(head.sections[gdwg::binary::dst_section].offset));
+			out.put(9);
+		}
+		auto const mg = gdwg::mapped_graph<std::string, int>(file.path);
+		REQUIRE_THROWS_WITH(mg.verify(), "Cannot call gdwg::mapped_graph<N, E>::verify on a corrupt binary graph");
+	}
+
+	SECTION("an outgoing edge out of order is caught by verify()") {
+		gdwg::save_binary(sample_graph(), file.path);
+		auto const head = [&file] {
+			auto in = std::ifstream(file.path, std::ios::binary);
+			auto bytes = std::vector<char>(sizeof(gdwg::binary::header));
+			in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+			return gdwg::binary::read<gdwg::binary::header>(bytes.data());
+		}();
+		// A's first edge now goes to C, ahead of its edges to B; every destination is still a valid node.
+		{
+			auto out = std::fstream(file.path, std::ios::binary | std::ios::in | std::ios::out);
+			out.seekp(static_cast<std::streamoff>(head.sections[gdwg::binary::dst_section].offset));
+			out.put(2);
+		}
+		auto const mg = gdwg::mapped_graph<std::string, int>(file.path);
+		REQUIRE_THROWS_WITH(mg.verify(), "Cannot call gdwg::mapped_graph<N, E>::verify on a corrupt binary graph");
+	}
+}
@@ -0,0 +1,588 @@
+#ifndef GDWG_PERSISTENT_GRAPH_H
+#define GDWG_PERSISTENT_GRAPH_H
+
+#include "gdwg_graph.h"
+
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace gdwg {
+	// A graph whose versions are immutable values. Every modifier returns a new version and leaves the one it was
+	// called on untouched, and the two share all of their storage except the tree nodes on the paths that changed.
+	//
+	// Nodes and edges are kept in treaps, balanced search trees whose nodes are never modified once built, so a new
+	// version copies O(log n) tree nodes per element it adds or removes. Edges are indexed twice: by (src, dst,
+	// weight) for queries and iteration, and by (dst, src, weight) to find the edges entering a node. A tree node's
+	// priority is the hash of its element, so the shape of a tree depends only on what it holds.
+	//
+	// This makes a persistent_graph a copy-on-write graph: copying a version is O(1), and changing it copies only
+	// the paths it touches. A writer keeps the current version and replaces it with what each modifier returns,
+	// and readers copy it as a snapshot that no later version changes. Only the variable holding the current
+	// version is shared, so only reading and replacing it needs a lock.
+	template<typename N, typename E>
+	class persistent_graph {
+	 public:
+		using edge = gdwg::edge<N, E>;
+
+		struct value_type {
+			N from;
+			N to;
+			std::optional<E> weight;
+		};
+
+	 private:
+		template<typename T, typename Less>
+		class treap {
+		 public:
+			struct node;
+			using link = std::shared_ptr<node const>;
+
+			struct node {
+				T value;
+				std::size_t priority;
+				link left;
+				link right;
+			};
+
+			// Inserts value, which must not already be in t.
+			static auto insert(link const& t, T const& value, std::size_t priority) -> link {
+				if (t == nullptr) {
+					return make(value, priority, nullptr, nullptr);
+				}
+				if (priority > t->priority or (priority == t->priority and Less{}(value, t->value))) {
+					auto [left, right] = split(t, [&value](T const& x) { return Less{}(x, value); });
+					return make(value, priority, std::move(left), std::move(right));
+				}
+				if (Less{}(value, t->value)) {
+					return make(t->value, t->priority, insert(t->left, value, priority), t->right);
+				}
+				return make(t->value, t->priority, t->left, insert(t->right, value, priority));
+			}
+
+			// Returns t itself when value is not in it.
+			static auto erase(link const& t, T const& value) -> link {
+				if (t == nullptr) {
+					return t;
+				}
+				if (Less{}(value, t->value)) {
+					auto left = erase(t->left, value);
+					return left == t->left ? t : make(t->value, t->priority, std::move(left), t->right);
+				}
+				if (Less{}(t->value, value)) {
+					auto right = erase(t->right, value);
+					return right == t->right ? t : make(t->value, t->priority, t->left, std::move(right));
+				}
+				return merge(t->left, t->right);
+			}
+
+			// Splits t into the elements for which goes_left holds and the rest. goes_left must hold for a prefix.
+			template<typename Pred>
+			static auto split(link const& t, Pred const& goes_left) -> std::pair<link, link> {
+				if (t == nullptr) {
+					return {};
+				}
+				if (goes_left(t->value)) {
+					auto [left, right] = split(t->right, goes_left);
+					return {make(t->value, t->priority, t->left, std::move(left)), std::move(right)};
+				}
+				auto [left, right] = split(t->left, goes_left);
+				return {std::move(left), make(t->value, t->priority, std::move(right), t->right)};
+			}
+
+			// Joins two trees where every element of lhs is less than every element of rhs.
+			static auto merge(link const& lhs, link const& rhs) -> link {
+				if (lhs == nullptr) {
+					return rhs;
+				}
+				if (rhs == nullptr) {
+					return lhs;
+				}
+				if (lhs->priority >= rhs->priority) {
+					return make(lhs->value, lhs->priority, lhs->left, merge(lhs->right, rhs));
+				}
+				return make(rhs->value, rhs->priority, merge(lhs, rhs->left), rhs->right);
+			}
+
+			static auto find(link const& t, T const& value) -> node const* {
+				auto const* n = t.get();
+				while (n != nullptr) {
+					if (Less{}(value, n->value)) {
+						n = n->left.get();
+					}
+					else if (Less{}(n->value, value)) {
+						n = n->right.get();
+					}
+					else {
+						return n;
+					}
+				}
+				return nullptr;
+			}
+
+			// Visits, in order, the elements that are neither before nor after a range, skipping every subtree
+			// that lies wholly outside it.
+			template<typename Before, typename After, typename Fn>
+			static auto for_each(node const* n, Before const& before, After const& after, Fn& fn) -> void {
+				while (n != nullptr) {
+					if (before(n->value)) {
+						n = n->right.get();
+					}
+					else if (after(n->value)) {
+						n = n->left.get();
+					}
+					else {
+						for_each(n->left.get(), before, after, fn);
+						fn(n->value);
+						n = n->right.get();
+					}
+				}
+			}
+
+		 private:
+			static auto make(T const& value, std::size_t priority, link left, link right) -> link {
+				return std::make_shared<node const>(node{value, priority, std::move(left), std::move(right)});
+			}
+		};
+
+		struct out_order {
+			auto operator()(value_type const& lhs, value_type const& rhs) const -> bool {
+				return std::tie(lhs.from, lhs.to, lhs.weight) < std::tie(rhs.from, rhs.to, rhs.weight);
+			}
+		};
+
+		struct in_order {
+			auto operator()(value_type const& lhs, value_type const& rhs) const -> bool {
+				return std::tie(lhs.to, lhs.from, lhs.weight) < std::tie(rhs.to, rhs.from, rhs.weight);
+			}
+		};
+
+		using node_tree = treap<N, std::less<N>>;
+		using out_tree = treap<value_type, out_order>;
+		using in_tree = treap<value_type, in_order>;
+
+	 public:
+		class iterator {
+		 public:
+			using value_type = persistent_graph::value_type;
+			using reference = value_type const&;
+			using pointer = value_type const*;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::forward_iterator_tag;
+
+			iterator() = default;
+
+			// Iterator source
+			auto operator*() const -> reference {
+				return path_.back()->value;
+			}
+			auto operator->() const -> pointer {
+				return &path_.back()->value;
+			}
+
+			// Iterator traversal
+			auto operator++() -> iterator& {
+				auto const* right = path_.back()->right.get();
+				path_.pop_back();
+				push_leftmost(right);
+				return *this;
+			}
+			auto operator++(int) -> iterator {
+				auto temp = *this;
+				++*this;
+				return temp;
+			}
+
+			// Iterator comparison
+			auto operator==(iterator const& other) const -> bool {
+				if (path_.empty() or other.path_.empty()) {
+					return path_.empty() and other.path_.empty();
+				}
+				return path_.back() == other.path_.back();
+			}
+
+		 private:
+			auto push_leftmost(typename out_tree::node const* n) -> void {
+				for (; n != nullptr; n = n->left.get()) {
+					path_.push_back(n);
+				}
+			}
+
+			// The current tree node last, after every ancestor whose right part is still to be visited.
+			std::vector<typename out_tree::node const*> path_;
+			friend class persistent_graph<N, E>;
+		};
+
+		persistent_graph() = default;
+		persistent_graph(std::initializer_list<N> il);
+		template<typename InputIt>
+		persistent_graph(InputIt first, InputIt last);
+		explicit persistent_graph(graph<N, E> const& g);
+
+		[[nodiscard]] auto insert_node(N const& value) const -> persistent_graph;
+		[[nodiscard]] auto insert_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const
+		    -> persistent_graph;
+		[[nodiscard]] auto replace_node(N const& old_data, N const& new_data) const -> persistent_graph;
+		[[nodiscard]] auto merge_replace_node(N const& old_data, N const& new_data) const -> persistent_graph;
+		[[nodiscard]] auto erase_node(N const& value) const -> persistent_graph;
+		[[nodiscard]] auto erase_edge(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const
+		    -> persistent_graph;
+		[[nodiscard]] auto clear() const noexcept -> persistent_graph;
+
+		[[nodiscard]] auto is_node(N const& value) const -> bool;
+		[[nodiscard]] auto empty() const noexcept -> bool;
+		[[nodiscard]] auto is_connected(N const& src, N const& dst) const -> bool;
+		[[nodiscard]] auto nodes() const -> std::vector<N>;
+		[[nodiscard]] auto edges(N const& src, N const& dst) const -> std::vector<std::unique_ptr<edge>>;
+		[[nodiscard]] auto find(N const& src, N const& dst, std::optional<E> weight = std::nullopt) const -> iterator;
+		[[nodiscard]] auto connections(N const& src) const -> std::vector<N>;
+
+		[[nodiscard]] auto begin() const -> iterator;
+		[[nodiscard]] auto end() const -> iterator;
+
+		[[nodiscard]] auto operator==(persistent_graph const& other) const -> bool;
+
+	 private:
+		static auto node_priority(N const& value) -> std::size_t;
+		static auto edge_priority(value_type const& e) -> std::size_t;
+		auto with_edge(value_type const& e) const -> persistent_graph;
+		auto without_edge(value_type const& e) const -> persistent_graph;
+		// Removes value and every edge incident to it, and returns those edges.
+		auto detach_node(N const& value) -> std::vector<value_type>;
+		// Moves every edge of old_data to new_data, which may already exist, and removes old_data.
+		auto relabel_node(N const& old_data, N const& new_data) const -> persistent_graph;
+
+		typename node_tree::link nodes_;
+		typename out_tree::link out_;
+		typename in_tree::link in_;
+	};
+
+	template<typename N, typename E>
+	persistent_graph<N, E>::persistent_graph(std::initializer_list<N> il)
+	: persistent_graph(il.begin(), il.end()) {}
+
+	template<typename N, typename E>
+	template<typename InputIt>
+	persistent_graph<N, E>::persistent_graph(InputIt first, InputIt last) {
+		for (auto it = first; it != last; ++it) {
+			if (node_tree::find(nodes_, *it) == nullptr) {
+				nodes_ = node_tree::insert(nodes_, *it, node_priority(*it));
+			}
+		}
+	}
+
+	template<typename N, typename E>
+	persistent_graph<N, E>::persistent_graph(graph<N, E> const& g) {
+		for (auto const& value : g.nodes()) {
+			nodes_ = node_tree::insert(nodes_, value, node_priority(value));
+		}
+		for (auto const& [from, to, weight] : g.edge_refs()) {
+			auto const e = value_type{from, to, weight != nullptr ? std::optional<E>(*weight) : std::nullopt};
+			auto const priority = edge_priority(e);
+			out_ = out_tree::insert(out_, e, priority);
+			in_ = in_tree::insert(in_, e, priority);
+		}
+	}
+
+	// Priorities are mixed hashes of the elements, so they look random.
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::node_priority(N const& value) -> std::size_t {
+		return mix_hash(boost::hash<N>{}(value));
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::edge_priority(value_type const& e) -> std::size_t {
+		auto seed = boost::hash<N>{}(e.from);
+		boost::hash_combine(seed, e.to);
+		boost::hash_combine(seed, e.weight.has_value());
+		if (e.weight) {
+			boost::hash_combine(seed, *e.weight);
+		}
+		return mix_hash(seed);
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::with_edge(value_type const& e) const -> persistent_graph {
+		if (out_tree::find(out_, e) != nullptr) {
+			return *this;
+		}
+		auto result = *this;
+		auto const priority = edge_priority(e);
+		result.out_ = out_tree::insert(out_, e, priority);
+		result.in_ = in_tree::insert(in_, e, priority);
+		return result;
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::without_edge(value_type const& e) const -> persistent_graph {
+		auto result = *this;
+		result.out_ = out_tree::erase(out_, e);
+		result.in_ = in_tree::erase(in_, e);
+		return result;
+	}
+
+	// The node's outgoing edges are one block of out_ and its incoming edges one block of in_, so each block is cut
+	// out with two splits. Every edge in a block is also erased from the other index, which costs O(log n) per edge.
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::detach_node(N const& value) -> std::vector<value_type> {
+		auto const from_before = [&value](value_type const& e) { return e.from < value; };
+		auto const from_up_to = [&value](value_type const& e) { return not(value < e.from); };
+		auto const to_before = [&value](value_type const& e) { return e.to < value; };
+		auto const to_up_to = [&value](value_type const& e) { return not(value < e.to); };
+		auto [out_before, out_rest] = out_tree::split(out_, from_before);
+		auto [outgoing, out_after] = out_tree::split(out_rest, from_up_to);
+		auto [in_before, in_rest] = in_tree::split(in_, to_before);
+		auto [incoming, in_after] = in_tree::split(in_rest, to_up_to);
+		out_ = out_tree::merge(out_before, out_after);
+		in_ = in_tree::merge(in_before, in_after);
+
+		auto result = std::vector<value_type>{};
+		auto const none = [](value_type const&) { return false; };
+		auto collect_outgoing = [this, &result](value_type const& e) {
+			in_ = in_tree::erase(in_, e);
+			result.push_back(e);
+		};
+		out_tree::for_each(outgoing.get(), none, none, collect_outgoing);
+		auto collect_incoming = [this, &result, &value](value_type const& e) {
+			// Self-loops were collected with the outgoing edges.
+			if (e.from != value) {
+				out_ = out_tree::erase(out_, e);
+				result.push_back(e);
+			}
+		};
+		in_tree::for_each(incoming.get(), none, none, collect_incoming);
+
+		nodes_ = node_tree::erase(nodes_, value);
+		return result;
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::relabel_node(N const& old_data, N const& new_data) const -> persistent_graph {
+		auto result = *this;
+		auto const detached = result.detach_node(old_data);
+		result = result.insert_node(new_data);
+		for (auto e : detached) {
+			if (e.from == old_data) {
+				e.from = new_data;
+			}
+			if (e.to == old_data) {
+				e.to = new_data;
+			}
+			result = result.with_edge(e);
+		}
+		return result;
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::insert_node(N const& value) const -> persistent_graph {
+		if (is_node(value)) {
+			return *this;
+		}
+		auto result = *this;
+		result.nodes_ = node_tree::insert(nodes_, value, node_priority(value));
+		return result;
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::insert_edge(N const& src, N const& dst, std::optional<E> weight) const
+	    -> persistent_graph {
+		if (not is_node(src) or not is_node(dst)) {
+			throw std::runtime_error("Cannot call gdwg::persistent_graph<N, E>::insert_edge when either src or dst "
+			                         "node does not exist");
+		}
+		return with_edge({src, dst, std::move(weight)});
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::replace_node(N const& old_data, N const& new_data) const -> persistent_graph {
+		if (not is_node(old_data)) {
+			throw std::runtime_error("Cannot call gdwg::persistent_graph<N, E>::replace_node on a node that doesn't "
+			                         "exist");
+		}
+		if (is_node(new_data)) {
+			return *this;
+		}
+		return relabel_node(old_data, new_data);
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::merge_replace_node(N const& old_data, N const& new_data) const -> persistent_graph {
+		if (not is_node(old_data) or not is_node(new_data)) {
+			throw std::runtime_error("Cannot call gdwg::persistent_graph<N, E>::merge_replace_node on old or new data "
+			                         "if they don't exist in the graph");
+		}
+		if (old_data == new_data) {
+			return *this;
+		}
+		return relabel_node(old_data, new_data);
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::erase_node(N const& value) const -> persistent_graph {
+		if (not is_node(value)) {
+			return *this;
+		}
+		auto result = *this;
+		result.detach_node(value);
+		return result;
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::erase_edge(N const& src, N const& dst, std::optional<E> weight) const
+	    -> persistent_graph {
+		if (not is_node(src) or not is_node(dst)) {
+			throw std::runtime_error("Cannot call gdwg::persistent_graph<N, E>::erase_edge on src or dst if they "
+			                         "don't exist in the graph");
+		}
+		return without_edge({src, dst, std::move(weight)});
+	}
+
+	template<typename N, typename E>
+	auto persistent_graph<N, E>::clear() const noexcept -> persistent_graph {
+		return persistent_graph();
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::is_node(N const& value) const -> bool {
+		return node_tree::find(nodes_, value) != nullptr;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::empty() const noexcept -> bool {
+		return nodes_ == nullptr;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::is_connected(N const& src, N const& dst) const -> bool {
+		if (not is_node(src) or not is_node(dst)) {
+			throw std::runtime_error("Cannot call gdwg::persistent_graph<N, E>::is_connected if src or dst node "
+			                         "don't exist in the graph");
+		}
+
+		// Any edge of the (src, dst) run will do, so the search compares nodes only.
+		auto const key = std::tie(src, dst);
+		for (auto const* n = out_.get(); n != nullptr;) {
+			auto const here = std::tie(n->value.from, n->value.to);
+			if (here < key) {
+				n = n->right.get();
+			}
+			else if (key < here) {
+				n = n->left.get();
+			}
+			else {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::nodes() const -> std::vector<N> {
+		auto result = std::vector<N>{};
+		auto const none = [](N const&) { return false; };
+		auto collect = [&result](N const& value) { result.push_back(value); };
+		node_tree::for_each(nodes_.get(), none, none, collect);
+		return result;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::edges(N const& src, N const& dst) const
+	    -> std::vector<std::unique_ptr<edge>> {
+		if (not is_node(src) or not is_node(dst)) {
+			throw std::runtime_error("Cannot call gdwg::persistent_graph<N, E>::edges if src or dst node don't exist "
+			                         "in the graph");
+		}
+
+		auto result = std::vector<std::unique_ptr<edge>>{};
+		auto const key = std::tie(src, dst);
+		auto const before = [&key](value_type const& e) { return std::tie(e.from, e.to) < key; };
+		auto const after = [&key](value_type const& e) { return key < std::tie(e.from, e.to); };
+		auto collect = [&result, &src, &dst](value_type const& e) {
+			if (e.weight) {
+				result.push_back(std::make_unique<weighted_edge<N, E>>(src, dst, *e.weight));
+			}
+			else {
+				result.push_back(std::make_unique<unweighted_edge<N, E>>(src, dst));
+			}
+		};
+		out_tree::for_each(out_.get(), before, after, collect);
+		return result;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::find(N const& src, N const& dst, std::optional<E> weight) const
+	    -> iterator {
+		auto const key = value_type{src, dst, std::move(weight)};
+		auto const less = out_order{};
+		auto result = iterator{};
+		for (auto const* n = out_.get(); n != nullptr;) {
+			if (less(key, n->value)) {
+				result.path_.push_back(n);
+				n = n->left.get();
+			}
+			else if (less(n->value, key)) {
+				n = n->right.get();
+			}
+			else {
+				result.path_.push_back(n);
+				return result;
+			}
+		}
+		return end();
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::connections(N const& src) const -> std::vector<N> {
+		if (not is_node(src)) {
+			throw std::runtime_error("Cannot call gdwg::persistent_graph<N, E>::connections if src doesn't exist in "
+			                         "the graph");
+		}
+
+		auto result = std::vector<N>{};
+		auto const before = [&src](value_type const& e) { return e.from < src; };
+		auto const after = [&src](value_type const& e) { return src < e.from; };
+		auto collect = [&result](value_type const& e) { result.push_back(e.to); };
+		out_tree::for_each(out_.get(), before, after, collect);
+		return result;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::begin() const -> iterator {
+		auto result = iterator{};
+		result.push_leftmost(out_.get());
+		return result;
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::end() const -> iterator {
+		return iterator{};
+	}
+
+	template<typename N, typename E>
+	[[nodiscard]] auto persistent_graph<N, E>::operator==(persistent_graph const& other) const -> bool {
+		if (nodes_ != other.nodes_ and nodes() != other.nodes()) {
+			return false;
+		}
+		// Versions that share their edge tree are equal without looking inside it.
+		if (out_ == other.out_) {
+			return true;
+		}
+		auto const same_edge = [](value_type const& lhs, value_type const& rhs) {
+			return lhs.from == rhs.from and lhs.to == rhs.to and lhs.weight == rhs.weight;
+		};
+		return std::equal(begin(), end(), other.begin(), other.end(), same_edge);
+	}
+
+} // namespace gdwg
+
+#endif // GDWG_PERSISTENT_GRAPH_H
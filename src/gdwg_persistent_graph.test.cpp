@@ -0,0 +1,214 @@
+#include "gdwg_persistent_graph.h"
+#include "gdwg_test_helpers.h"
+
+#include <catch2/catch.hpp>
+
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+using gdwg::test::edge_list;
+using gdwg::test::sample_graph;
+
+namespace {
+	using persistent = gdwg::persistent_graph<std::string, int>;
+} // namespace
+
+TEST_CASE("Default constructed persistent_graph is empty", "[persistent_graph]") {
+	auto const pg = persistent{};
+
+	REQUIRE(pg.empty());
+	REQUIRE(pg.nodes().empty());
+	REQUIRE(pg.begin() == pg.end());
+}
+
+TEST_CASE("persistent_graph holds the same nodes and edges as the graph", "[persistent_graph]") {
+	auto const g = sample_graph();
+	auto const pg = persistent(g);
+
+	REQUIRE(pg.nodes() == g.nodes());
+	REQUIRE(edge_list(pg) == edge_list(g));
+	REQUIRE(pg == persistent(sample_graph()));
+}
+
+TEST_CASE("persistent_graph modifiers return a new version and leave the old one unchanged", "[persistent_graph]") {
+	auto const g = sample_graph();
+	auto const v1 = persistent(g);
+
+	SECTION("insert_node") {
+		auto const v2 = v1.insert_node("E");
+		REQUIRE(v2.is_node("E"));
+		REQUIRE_FALSE(v1.is_node("E"));
+		REQUIRE(v1.insert_node("A") == v1);
+	}
+
+	SECTION("insert_edge") {
+		auto const v2 = v1.insert_edge("D", "A", 4);
+		REQUIRE(v2.is_connected("D", "A"));
+		REQUIRE_FALSE(v1.is_connected("D", "A"));
+		REQUIRE(v1.insert_edge("A", "B", 3) == v1);
+		REQUIRE_THROWS_WITH(v1.insert_edge("A", "E"),
+		                    "Cannot call gdwg::persistent_graph<N, E>::insert_edge when either src or dst node does "
+		                    "not exist");
+	}
+
+	SECTION("erase_edge") {
+		auto const v2 = v1.erase_edge("A", "B", 1);
+		REQUIRE(v2.find("A", "B", 1) == v2.end());
+		REQUIRE(v1.find("A", "B", 1) != v1.end());
+		REQUIRE(v1.erase_edge("B", "A") == v1);
+	}
+
+	SECTION("erase_node") {
+		auto const v2 = v1.erase_node("C");
+		auto expected = g;
+		expected.erase_node("C");
+		REQUIRE(v2.nodes() == expected.nodes());
+		REQUIRE(edge_list(v2) == edge_list(expected));
+		REQUIRE(edge_list(v1) == edge_list(g));
+		REQUIRE(v1.erase_node("E") == v1);
+	}
+
+	SECTION("replace_node") {
+		auto const v2 = v1.replace_node("A", "E");
+		auto expected = g;
+		expected.replace_node("A", "E");
+		REQUIRE(v2.nodes() == expected.nodes());
+		REQUIRE(edge_list(v2) == edge_list(expected));
+		REQUIRE(v1.is_node("A"));
+		REQUIRE(v1.replace_node("A", "B") == v1);
+		REQUIRE_THROWS_WITH(v1.replace_node("E", "F"),
+		                    "Cannot call gdwg::persistent_graph<N, E>::replace_node on a node that doesn't exist");
+	}
+
+	SECTION("merge_replace_node") {
+		auto const v2 = v1.merge_replace_node("A", "C");
+		auto expected = g;
+		expected.merge_replace_node("A", "C");
+		REQUIRE(v2.nodes() == expected.nodes());
+		REQUIRE(edge_list(v2) == edge_list(expected));
+		REQUIRE(edge_list(v1) == edge_list(g));
+		REQUIRE(v1.merge_replace_node("A", "A") == v1);
+		REQUIRE_THROWS_WITH(v1.merge_replace_node("A", "E"),
+		                    "Cannot call gdwg::persistent_graph<N, E>::merge_replace_node on old or new data if they "
+		                    "don't exist in the graph");
+	}
+
+	SECTION("clear") {
+		REQUIRE(v1.clear().empty());
+		REQUIRE_FALSE(v1.empty());
+	}
+}
+
+TEST_CASE("persistent_graph copies are snapshots of a changing graph", "[persistent_graph]") {
+	auto live = persistent(sample_graph());
+	auto const snapshot = live;
+	auto const edges = edge_list(snapshot);
+
+	live = live.insert_edge("D", "A", 4);
+	live = live.erase_edge("A", "B", 1);
+	live = live.erase_node("C");
+
+	REQUIRE(edge_list(snapshot) == edges);
+	REQUIRE(snapshot == persistent(sample_graph()));
+	REQUIRE(edge_list(live) == edge_list(persistent{"A", "B", "D"}.insert_edge("A", "B", 3).insert_edge("A", "B")
+	                                     .insert_edge("D", "A", 4)));
+}
+
+TEST_CASE("persistent_graph answers queries like the graph", "[persistent_graph]") {
+	auto const g = sample_graph();
+	auto const pg = persistent(g);
+
+	SECTION("is_connected") {
+		REQUIRE(pg.is_connected("A", "B"));
+		REQUIRE(pg.is_connected("C", "C"));
+		REQUIRE_FALSE(pg.is_connected("B", "A"));
+		REQUIRE_THROWS_WITH(pg.is_connected("A", "E"),
+		                    "Cannot call gdwg::persistent_graph<N, E>::is_connected if src or dst node don't exist "
+		                    "in the graph");
+	}
+
+	SECTION("find") {
+		REQUIRE(pg.find("A", "B")->weight == std::nullopt);
+		REQUIRE(pg.find("A", "B", 3)->weight == 3);
+		REQUIRE(pg.find("A", "B", 2) == pg.end());
+		REQUIRE(pg.find("A", "E") == pg.end());
+		REQUIRE(std::next(pg.find("A", "B", 3)) == pg.find("A", "C", 2));
+	}
+
+	SECTION("connections") {
+		REQUIRE(pg.connections("A") == g.connections("A"));
+		REQUIRE(pg.connections("D").empty());
+		REQUIRE_THROWS_WITH(pg.connections("E"),
+		                    "Cannot call gdwg::persistent_graph<N, E>::connections if src doesn't exist in the graph");
+	}
+
+	SECTION("edges") {
+		auto const edges = pg.edges("A", "B");
+		REQUIRE(edges.size() == 3);
+		REQUIRE(edges[0]->print_edge() == "A -> B | U");
+		REQUIRE(edges[1]->print_edge() == "A -> B | W | 1");
+		REQUIRE(edges[2]->print_edge() == "A -> B | W | 3");
+		REQUIRE(pg.edges("B", "A").empty());
+	}
+}
+
+TEST_CASE("persistent_graph versions match a graph given the same changes", "[persistent_graph]") {
+	auto g = gdwg::graph<std::string, int>{"0", "1", "2", "3"};
+	auto pg = persistent{"0", "1", "2", "3"};
+	auto versions = std::vector<persistent>{pg};
+	auto snapshots = std::vector<gdwg::graph<std::string, int>>{g};
+
+	// A fixed pseudo-random walk over every modifier.
+	auto state = 7U;
+	auto const next = [&state](unsigned bound) {
+		state = state * 1103515245U + 12345U;
+		return (state >> 16U) % bound;
+	};
+	for (auto step = 0; step < 400; ++step) {
+		auto const a = std::to_string(next(6));
+		auto const b = std::to_string(next(6));
+		auto const weight = next(4) == 0 ? std::nullopt : std::optional<int>(static_cast<int>(next(3)));
+		switch (next(6)) {
+		case 0:
+			g.insert_node(a);
+			pg = pg.insert_node(a);
+			break;
+		case 1:
+		case 2:
+			if (g.is_node(a) and g.is_node(b)) {
+				g.insert_edge(a, b, weight);
+				pg = pg.insert_edge(a, b, weight);
+			}
+			break;
+		case 3:
+			if (g.is_node(a) and g.is_node(b)) {
+				g.erase_edge(a, b, weight);
+				pg = pg.erase_edge(a, b, weight);
+			}
+			break;
+		case 4:
+			g.erase_node(a);
+			pg = pg.erase_node(a);
+			break;
+		case 5:
+			if (g.is_node(a) and g.is_node(b)) {
+				g.merge_replace_node(a, b);
+				pg = pg.merge_replace_node(a, b);
+			}
+			else if (g.is_node(a)) {
+				g.replace_node(a, b);
+				pg = pg.replace_node(a, b);
+			}
+			break;
+		}
+		versions.push_back(pg);
+		snapshots.push_back(g);
+	}
+
+	for (auto i = std::size_t{0}; i < versions.size(); ++i) {
+		REQUIRE(versions[i].nodes() == snapshots[i].nodes());
+		REQUIRE(edge_list(versions[i]) == edge_list(snapshots[i]));
+	}
+}
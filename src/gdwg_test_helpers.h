@@ -0,0 +1,61 @@
+#ifndef GDWG_TEST_HELPERS_H
+#define GDWG_TEST_HELPERS_H
+
+#include "gdwg_graph.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Fixtures shared by the test files of the graph types built on gdwg::graph.
+namespace gdwg::test {
+	// Four nodes, with three edges from A to B (two weighted, one not), a self loop and a node with no edges.
+	inline auto sample_graph() -> graph<std::string, int> {
+		auto g = graph<std::string, int>{"A", "B", "C", "D"};
+		g.insert_edge("A", "B", 3);
+		g.insert_edge("A", "B", 1);
+		g.insert_edge("A", "B");
+		g.insert_edge("A", "C", 2);
+		g.insert_edge("C", "A", 5);
+		g.insert_edge("C", "C");
+		return g;
+	}
+
+	// The edges of any graph type, in iteration order, as (from, to, weight) tuples.
+	template<typename Graph>
+	auto edge_list(Graph const& g) {
+		using N = std::decay_t<decltype((*g.begin()).from)>;
+		using W = std::decay_t<decltype((*g.begin()).weight)>;
+		auto result = std::vector<std::tuple<N, N, W>>{};
+		for (auto const& [from, to, weight] : g) {
+			result.emplace_back(from, to, weight);
+		}
+		return result;
+	}
+
+	// A file in the temporary directory, removed when the test ends. The path holds the process id, so test
+	// executables that ctest runs in parallel never share a file.
+	struct temp_file {
+		explicit temp_file(std::string const& name)
+		: path(std::filesystem::temp_directory_path()
+		       / ("gdwg_test_" + std::to_string(::getpid()) + "_" + name)) {}
+		temp_file(std::string const& name, std::string const& contents)
+		: temp_file(name) {
+			std::ofstream(path, std::ios::binary) << contents;
+		}
+		temp_file(temp_file const&) = delete;
+		auto operator=(temp_file const&) -> temp_file& = delete;
+		~temp_file() {
+			std::filesystem::remove(path);
+		}
+
+		std::filesystem::path path;
+	};
+} // namespace gdwg::test
+
+#endif // GDWG_TEST_HELPERS_H
@@ -0,0 +1,569 @@
+#ifndef GDWG_TEXT_H
+#define GDWG_TEXT_H
+
+#include "gdwg_graph.h"
+
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <ios>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gdwg {
+	// Readers for graphs written as text: the operator<< format and whitespace-separated edge lists.
+	//
+	// Input is read straight from the stream buffer in large blocks and cut into lines in place, so a line is only
+	// copied when it spans two blocks. Numbers are parsed with std::from_chars and std::string values are views of the
+	// block until their node is first seen. Everything read is collected in a graph_builder, which builds the graph
+	// with one insert_nodes() and one insert_edges() call.
+	namespace text {
+		inline constexpr auto block_size = std::size_t{1} << 20;
+
+		// Types written as plain numbers by operator<<. Character types are written as characters instead.
+		template<typename T>
+		concept number = (std::integral<T> and sizeof(T) > 1) or std::floating_point<T>;
+
+		// The value written as text, or nullopt if the whole text is not a valid T.
+		template<typename T>
+		auto parse(std::string_view text) -> std::optional<T> {
+			if constexpr (std::same_as<T, std::string>) {
+				return std::string(text);
+			}
+			else if constexpr (number<T>) {
+				auto value = T{};
+				auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+				if (error != std::errc{} or end != text.data() + text.size()) {
+					return std::nullopt;
+				}
+				return value;
+			}
+			else {
+				auto in = std::istringstream(std::string(text));
+				auto value = T{};
+				if (not(in >> value) or not(in >> std::ws).eof()) {
+					return std::nullopt;
+				}
+				return value;
+			}
+		}
+
+		// Calls fn on every line read from in, without its '\n', until fn returns false. A last line without a '\n'
+		// is passed on too. Returns false if fn stopped early.
+		template<typename F>
+		auto for_each_line(std::streambuf& in, F fn) -> bool {
+			auto buffer = std::vector<char>(block_size);
+			// Bytes of a line carried over from the previous block.
+			auto carried = std::size_t{0};
+			while (true) {
+				if (carried == buffer.size()) {
+					buffer.resize(2 * buffer.size());
+				}
+				auto const space = static_cast<std::streamsize>(buffer.size() - carried);
+				auto const read = in.sgetn(buffer.data() + carried, space);
+				auto const* line = buffer.data();
+				auto const* const last = buffer.data() + carried + static_cast<std::size_t>(read);
+				while (auto const* newline =
+				           static_cast<char const*>(std::memchr(line, '\n', static_cast<std::size_t>(last - line))))
+				{
+					if (not fn(std::string_view(line, newline))) {
+						return false;
+					}
+					line = newline + 1;
+				}
+
+				carried = static_cast<std::size_t>(last - line);
+				if (read == 0) {
+					return carried == 0 or fn(std::string_view(line, last));
+				}
+				std::memmove(buffer.data(), line, carried);
+			}
+		}
+
+		// Calls fn(i) for every i below count, each on a thread of its own, and rethrows the first exception thrown.
+		template<typename F>
+		auto run_parallel(std::size_t count, F fn) -> void {
+			auto errors = std::vector<std::exception_ptr>(count);
+			{
+				auto workers = std::vector<std::jthread>{};
+				workers.reserve(count);
+				for (auto i = std::size_t{0}; i < count; ++i) {
+					workers.emplace_back([&fn, &errors, i] {
+						try {
+							fn(i);
+						} catch (...) {
+							errors[i] = std::current_exception();
+						}
+					});
+				}
+			}
+			for (auto const& error : errors) {
+				if (error) {
+					std::rethrow_exception(error);
+				}
+			}
+		}
+
+		// The bytes [first, last) of a file, read through a filebuf of its own so that parts of one file can be read
+		// on several threads.
+		class file_part : public std::streambuf {
+		 public:
+			file_part(std::filesystem::path const& path, std::uint64_t first, std::uint64_t last);
+			[[nodiscard]] auto is_open() const -> bool;
+
+		 protected:
+			auto underflow() -> int_type override;
+
+		 private:
+			std::filebuf file_;
+			std::uint64_t left_;
+			std::vector<char> buffer_ = std::vector<char>(block_size);
+		};
+
+		inline file_part::file_part(std::filesystem::path const& path, std::uint64_t first, std::uint64_t last)
+		: left_(last - first) {
+			if (file_.open(path, std::ios::in | std::ios::binary) != nullptr
+			    and file_.pubseekpos(static_cast<std::streamoff>(first), std::ios::in) == std::streampos(-1))
+			{
+				file_.close();
+			}
+		}
+
+		inline auto file_part::is_open() const -> bool {
+			return file_.is_open();
+		}
+
+		inline auto file_part::underflow() -> int_type {
+			auto const wanted = std::min<std::uint64_t>(left_, buffer_.size());
+			auto const read = wanted == 0 ? 0 : file_.sgetn(buffer_.data(), static_cast<std::streamsize>(wanted));
+			if (read <= 0) {
+				return traits_type::eof();
+			}
+			left_ -= static_cast<std::uint64_t>(read);
+			setg(buffer_.data(), buffer_.data(), buffer_.data() + read);
+			return traits_type::to_int_type(buffer_.front());
+		}
+
+		// Offsets that cut a file of the given size into count parts of about equal size, each starting at the start
+		// of a line. Part i is [starts[i], starts[i + 1]), and a line longer than a part leaves the next part empty.
+		inline auto part_starts(std::istream& file, std::uint64_t size, std::size_t count)
+		    -> std::vector<std::uint64_t> {
+			auto starts = std::vector<std::uint64_t>{0};
+			for (auto i = std::size_t{1}; i < count; ++i) {
+				auto const nominal = std::max(size * i / count, starts.back());
+				auto start = nominal;
+				if (nominal > 0 and nominal < size) {
+					// The line holding the byte before nominal ends at the first '\n' from there on.
+					file.clear();
+					file.seekg(static_cast<std::streamoff>(nominal - 1));
+					file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+					start = file.eof() ? size : static_cast<std::uint64_t>(file.tellg());
+				}
+				starts.push_back(start);
+			}
+			starts.push_back(size);
+			return starts;
+		}
+
+		// Nodes and edges read from text, before they are put into a graph. Nodes are interned as they are seen, so
+		// each distinct node is parsed and stored once and edges only hold node ids.
+		template<typename N, typename E>
+		class graph_builder {
+		 public:
+			// Id of the node written as text, adding the node the first time it is seen. Nullopt if the text is not a
+			// valid N.
+			auto node(std::string_view text) -> std::optional<std::uint32_t>;
+			auto edge(std::uint32_t src, std::uint32_t dst, std::optional<E> weight) -> void;
+			[[nodiscard]] auto build() && -> graph<N, E>;
+			// Builds one graph from builders that each read a part of the same input, with a thread per builder.
+			[[nodiscard]] static auto build(std::vector<graph_builder> parts) -> graph<N, E>;
+
+		 private:
+			// Strings are looked up by a view of the text, which for a new node is repointed at its stored copy.
+			using key = std::conditional_t<std::same_as<N, std::string>, std::string_view, N>;
+			using key_hash =
+			    std::conditional_t<std::same_as<N, std::string>, std::hash<std::string_view>, boost::hash<N>>;
+
+			// A slot of the intern table: a node's key and id + 1, or an id of 0 while the slot is empty.
+			struct slot {
+				key value = {};
+				std::uint32_t id = 0;
+			};
+
+			struct pending_edge {
+				std::uint32_t src;
+				std::uint32_t dst;
+				std::optional<E> weight;
+
+				// Graph order, once src and dst are ranks of the nodes by value.
+				friend auto operator<(pending_edge const& lhs, pending_edge const& rhs) -> bool {
+					return std::tie(lhs.src, lhs.dst, lhs.weight) < std::tie(rhs.src, rhs.dst, rhs.weight);
+				}
+				friend auto operator==(pending_edge const&, pending_edge const&) -> bool = default;
+			};
+
+			// First slot probed for a hash: its top bits after a Fibonacci multiply, which spreads identity hashes.
+			auto home(std::size_t hash) const -> std::size_t {
+				return static_cast<std::size_t>((std::uint64_t{hash} * 0x9E3779B97F4A7C15U) >> shift_);
+			}
+			auto grow() -> void;
+			template<typename Nodes>
+			static auto make_graph(Nodes const& nodes, std::vector<pending_edge>& edges) -> graph<N, E>;
+
+			// A deque never moves its elements, so views of stored strings stay valid.
+			std::deque<N> nodes_;
+			// Open-addressing table of node ids, probed linearly and at most half full. A lookup usually reads one
+			// small slot, where a node-based map reads a bucket, a list node and the key.
+			std::vector<slot> slots_ = std::vector<slot>(std::size_t{1} << 10);
+			int shift_ = 64 - 10;
+			std::vector<pending_edge> edges_;
+		};
+
+		template<typename N, typename E>
+		auto graph_builder<N, E>::node(std::string_view text) -> std::optional<std::uint32_t> {
+			auto value = std::optional<N>{};
+			if constexpr (not std::same_as<N, std::string>) {
+				value = parse<N>(text);
+				if (not value) {
+					return std::nullopt;
+				}
+			}
+			auto const lookup = [&] {
+				if constexpr (std::same_as<N, std::string>) {
+					return text;
+				}
+				else {
+					return *value;
+				}
+			}();
+
+			auto i = home(key_hash{}(lookup));
+			for (; slots_[i].id != 0; i = (i + 1) & (slots_.size() - 1)) {
+				if (slots_[i].value == lookup) {
+					return slots_[i].id - 1;
+				}
+			}
+
+			auto const id = static_cast<std::uint32_t>(nodes_.size());
+			if constexpr (std::same_as<N, std::string>) {
+				slots_[i] = {nodes_.emplace_back(text), id + 1};
+			}
+			else {
+				slots_[i] = {lookup, id + 1};
+				nodes_.push_back(std::move(*value));
+			}
+			if (2 * nodes_.size() > slots_.size()) {
+				grow();
+			}
+			return id;
+		}
+
+		template<typename N, typename E>
+		auto graph_builder<N, E>::grow() -> void {
+			auto old = std::exchange(slots_, std::vector<slot>(2 * slots_.size()));
+			--shift_;
+			for (auto& s : old) {
+				if (s.id != 0) {
+					auto i = home(key_hash{}(s.value));
+					while (slots_[i].id != 0) {
+						i = (i + 1) & (slots_.size() - 1);
+					}
+					slots_[i] = std::move(s);
+				}
+			}
+		}
+
+		template<typename N, typename E>
+		auto graph_builder<N, E>::edge(std::uint32_t src, std::uint32_t dst, std::optional<E> weight) -> void {
+			edges_.push_back({src, dst, std::move(weight)});
+		}
+
+		template<typename N, typename E>
+		[[nodiscard]] auto graph_builder<N, E>::build() && -> graph<N, E> {
+			return make_graph(nodes_, edges_);
+		}
+
+		// Nodes are ranked by value across all parts first, so that each part can sort its own edges into graph order
+		// on its thread. The sorted parts are then merged pairwise, half as many threads each round, dropping repeated
+		// edges as they meet, and the graph takes the result without sorting it again.
+		template<typename N, typename E>
+		[[nodiscard]] auto graph_builder<N, E>::build(std::vector<graph_builder> parts) -> graph<N, E> {
+			struct node_ref {
+				N* value;
+				std::uint32_t part;
+				std::uint32_t id;
+			};
+			auto refs = std::vector<node_ref>{};
+			auto ranks = std::vector<std::vector<std::uint32_t>>(parts.size());
+			for (auto p = std::size_t{0}; p < parts.size(); ++p) {
+				auto& part_nodes = parts[p].nodes_;
+				ranks[p].resize(part_nodes.size());
+				for (auto id = std::size_t{0}; id < part_nodes.size(); ++id) {
+					refs.push_back({&part_nodes[id], static_cast<std::uint32_t>(p), static_cast<std::uint32_t>(id)});
+				}
+			}
+			std::sort(refs.begin(), refs.end(), [](node_ref const& lhs, node_ref const& rhs) {
+				return *lhs.value < *rhs.value;
+			});
+
+			// A value is stored once per part, so a value moved out is never compared again.
+			auto nodes = std::vector<N>{};
+			for (auto const& ref : refs) {
+				if (nodes.empty() or nodes.back() < *ref.value) {
+					nodes.push_back(std::move(*ref.value));
+				}
+				ranks[ref.part][ref.id] = static_cast<std::uint32_t>(nodes.size() - 1);
+			}
+
+			auto runs = std::vector<std::vector<pending_edge>>(parts.size());
+			run_parallel(parts.size(), [&](std::size_t p) {
+				auto& run = runs[p];
+				run = std::move(parts[p].edges_);
+				for (auto& e : run) {
+					e.src = ranks[p][e.src];
+					e.dst = ranks[p][e.dst];
+				}
+				std::sort(run.begin(), run.end());
+				run.erase(std::unique(run.begin(), run.end()), run.end());
+			});
+			while (runs.size() > 1) {
+				auto merged = std::vector<std::vector<pending_edge>>((runs.size() + 1) / 2);
+				run_parallel(runs.size() / 2, [&](std::size_t i) {
+					auto& lhs = runs[2 * i];
+					auto& rhs = runs[2 * i + 1];
+					auto& out = merged[i];
+					out.reserve(lhs.size() + rhs.size());
+					std::merge(std::make_move_iterator(lhs.begin()),
+					           std::make_move_iterator(lhs.end()),
+					           std::make_move_iterator(rhs.begin()),
+					           std::make_move_iterator(rhs.end()),
+					           std::back_inserter(out));
+					out.erase(std::unique(out.begin(), out.end()), out.end());
+					lhs = {};
+					rhs = {};
+				});
+				if (runs.size() % 2 == 1) {
+					merged.back() = std::move(runs.back());
+				}
+				runs = std::move(merged);
+			}
+
+			auto edges = runs.empty() ? std::vector<pending_edge>{} : std::move(runs.front());
+			return make_graph(nodes, edges);
+		}
+
+		template<typename N, typename E>
+		template<typename Nodes>
+		auto graph_builder<N, E>::make_graph(Nodes const& nodes, std::vector<pending_edge>& edges) -> graph<N, E> {
+			auto g = graph<N, E>(nodes.begin(), nodes.end());
+			auto batch = std::vector<std::tuple<N const&, N const&, std::optional<E>>>{};
+			batch.reserve(edges.size());
+			for (auto& e : edges) {
+				batch.emplace_back(nodes[e.src], nodes[e.dst], std::move(e.weight));
+			}
+			g.insert_edges(batch.begin(), batch.end());
+			return g;
+		}
+
+		// Reads the operator<< format: for each node, a "node (" line, one "  src -> dst | W | weight" or
+		// "  src -> dst | U" line per edge, and a ")" line. Returns false if the text is not in that format.
+		//
+		// The source of an edge line is known from its block, so only the destination and weight are searched for.
+		// A destination or string weight containing " | W | " or ending in " | U" cannot be told apart from the
+		// separators; the first " | W | " is taken to end the destination.
+		template<typename N, typename E>
+		auto read_graph(std::streambuf& in, graph_builder<N, E>& builder) -> bool {
+			constexpr auto arrow = std::string_view(" -> ");
+			constexpr auto weighted = std::string_view(" | W | ");
+			constexpr auto unweighted = std::string_view(" | U");
+
+			// Node of the open block, and its text, which outlives the block of input it was read from.
+			auto src = std::optional<std::uint32_t>{};
+			auto src_text = std::string{};
+			auto const read = for_each_line(in, [&](std::string_view line) {
+				if (not src) {
+					if (line.empty()) {
+						return true;
+					}
+					if (not line.ends_with(" (")) {
+						return false;
+					}
+					src_text.assign(line.substr(0, line.size() - 2));
+					src = builder.node(src_text);
+					return src.has_value();
+				}
+				if (line == ")") {
+					src.reset();
+					return true;
+				}
+
+				if (not line.starts_with("  ") or not line.substr(2).starts_with(src_text)
+				    or not line.substr(2 + src_text.size()).starts_with(arrow))
+				{
+					return false;
+				}
+				auto const rest = line.substr(2 + src_text.size() + arrow.size());
+				auto dst = std::optional<std::uint32_t>{};
+				auto weight = std::optional<E>{};
+				if (auto const split = rest.find(weighted); split != std::string_view::npos) {
+					dst = builder.node(rest.substr(0, split));
+					weight = parse<E>(rest.substr(split + weighted.size()));
+					if (not weight) {
+						return false;
+					}
+				}
+				else if (rest.ends_with(unweighted)) {
+					dst = builder.node(rest.substr(0, rest.size() - unweighted.size()));
+				}
+				if (not dst) {
+					return false;
+				}
+				builder.edge(*src, *dst, std::move(weight));
+				return true;
+			});
+			return read and not src;
+		}
+
+		// Reads an edge list: one "src dst" or "src dst weight" line per edge, with fields separated by spaces or
+		// tabs. Blank lines and lines starting with '#' are skipped, and "\r\n" line ends are accepted. Returns the
+		// number of the first malformed line, counting from 1, or nullopt if every line is well formed.
+		template<typename N, typename E>
+		auto read_edge_list(std::streambuf& in, graph_builder<N, E>& builder) -> std::optional<std::size_t> {
+			auto line_number = std::size_t{0};
+			auto const read = for_each_line(in, [&](std::string_view line) {
+				++line_number;
+				auto const blank = [](char c) { return c == ' ' or c == '\t' or c == '\r'; };
+				auto fields = std::array<std::string_view, 3>{};
+				auto count = std::size_t{0};
+				auto const* p = line.data();
+				auto const* const end = line.data() + line.size();
+				while (true) {
+					while (p != end and blank(*p)) {
+						++p;
+					}
+					if (p == end) {
+						break;
+					}
+					if (count == fields.size() or (count == 0 and *p == '#')) {
+						return count == 0;
+					}
+					auto const* const first = p;
+					while (p != end and not blank(*p)) {
+						++p;
+					}
+					fields[count++] = std::string_view(first, p);
+				}
+				if (count == 0) {
+					return true;
+				}
+
+				auto const src = builder.node(fields[0]);
+				auto const dst = count >= 2 ? builder.node(fields[1]) : std::nullopt;
+				auto weight = count == 3 ? parse<E>(fields[2]) : std::nullopt;
+				if (not src or not dst or (count == 3 and not weight)) {
+					return false;
+				}
+				builder.edge(*src, *dst, std::move(weight));
+				return true;
+			});
+			return read ? std::nullopt : std::optional<std::size_t>(line_number);
+		}
+	} // namespace text
+
+	// Reads a graph in the format operator<< writes, replacing g, and consumes the rest of the stream. If the text is
+	// not in that format, sets failbit and leaves g unchanged.
+	template<typename N, typename E>
+	auto operator>>(std::istream& is, graph<N, E>& g) -> std::istream& {
+		auto const sentry = std::istream::sentry(is, true);
+		if (not sentry) {
+			return is;
+		}
+
+		auto builder = text::graph_builder<N, E>{};
+		if (not text::read_graph(*is.rdbuf(), builder)) {
+			is.setstate(std::ios_base::failbit);
+			return is;
+		}
+		g = std::move(builder).build();
+		is.setstate(std::ios_base::eofbit);
+		return is;
+	}
+
+	// Reads a graph from an edge list (see text::read_edge_list), adding every node named by an edge.
+	template<typename N, typename E>
+	auto read_edge_list(std::istream& is) -> graph<N, E> {
+		auto builder = text::graph_builder<N, E>{};
+		if (auto const line = text::read_edge_list(*is.rdbuf(), builder)) {
+			throw std::runtime_error("Cannot call gdwg::read_edge_list on input with a malformed line "
+			                         + std::to_string(*line));
+		}
+		return std::move(builder).build();
+	}
+
+	// Reads a graph from an edge list file on the given number of threads. The file is cut into one part per thread
+	// at line starts, each thread reads its part into a graph_builder of its own, and the parts are merged into one
+	// graph by graph_builder::build.
+	template<typename N, typename E>
+	auto read_edge_list(std::filesystem::path const& path, unsigned threads = std::thread::hardware_concurrency())
+	    -> graph<N, E> {
+		auto const count = std::size_t{std::max(threads, 1U)};
+		auto error = std::error_code{};
+		auto const size = std::uint64_t{std::filesystem::file_size(path, error)};
+		auto file = std::ifstream(path, std::ios::binary);
+		if (error or not file) {
+			throw std::runtime_error("Cannot call gdwg::read_edge_list on a file that cannot be read");
+		}
+		auto const starts = text::part_starts(file, size, count);
+
+		auto parts = std::vector<text::graph_builder<N, E>>(count);
+		auto malformed = std::vector<std::optional<std::size_t>>(count);
+		text::run_parallel(count, [&](std::size_t i) {
+			auto part = text::file_part(path, starts[i], starts[i + 1]);
+			if (not part.is_open()) {
+				throw std::runtime_error("Cannot call gdwg::read_edge_list on a file that cannot be read");
+			}
+			malformed[i] = text::read_edge_list(part, parts[i]);
+		});
+
+		auto const first_malformed = std::find_if(malformed.begin(), malformed.end(), [](auto const& line) {
+			return line.has_value();
+		});
+		if (first_malformed != malformed.end()) {
+			// Parts start at line starts, so the lines before a part are the lines read by the parts before it.
+			auto const part = static_cast<std::size_t>(first_malformed - malformed.begin());
+			auto before = text::file_part(path, 0, starts[part]);
+			auto line = **first_malformed;
+			text::for_each_line(before, [&line](std::string_view) {
+				++line;
+				return true;
+			});
+			throw std::runtime_error("Cannot call gdwg::read_edge_list on input with a malformed line "
+			                         + std::to_string(line));
+		}
+		return text::graph_builder<N, E>::build(std::move(parts));
+	}
+} // namespace gdwg
+
+#endif // GDWG_TEXT_H
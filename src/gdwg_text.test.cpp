@@ -0,0 +1,198 @@
+#include "gdwg_text.h"
+#include "gdwg_test_helpers.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using gdwg::test::sample_graph;
+using gdwg::test::temp_file;
+
+namespace {
+	template<typename N, typename E>
+	auto round_trip(gdwg::graph<N, E> const& g) -> gdwg::graph<N, E> {
+		auto out = std::ostringstream{};
+		out << g;
+		auto in = std::istringstream(out.str());
+		auto result = gdwg::graph<N, E>{};
+		in >> result;
+		REQUIRE_FALSE(in.fail());
+		return result;
+	}
+
+	// 318 lines holding 300 edges over 20 nodes, with comments, blank lines and repeated edges among them.
+	auto long_edge_list() -> std::string {
+		auto text = std::string{};
+		for (auto i = 0; i < 300; ++i) {
+			if (i % 37 == 0) {
+				text += "# part " + std::to_string(i) + "\n\n";
+			}
+			text += "n" + std::to_string(i * 7 % 20) + " n" + std::to_string(i * 11 % 20);
+			text += i % 3 == 0 ? "\n" : " " + std::to_string(i % 5) + "\n";
+		}
+		return text;
+	}
+} // namespace
+
+TEST_CASE("operator>> reads back what operator<< wrote", "[text]") {
+	SECTION("string nodes and int weights") {
+		auto const g = sample_graph();
+		REQUIRE(round_trip(g) == g);
+	}
+
+	SECTION("int nodes whose lines are not in edge order") {
+		auto g = gdwg::graph<int, int>{-4, 1, 9, 10};
+		g.insert_edge(1, 9, 10);
+		g.insert_edge(1, 9, -1);
+		g.insert_edge(1, 9, -4);
+		g.insert_edge(1, 10);
+		g.insert_edge(10, -4, 0);
+		REQUIRE(round_trip(g) == g);
+	}
+
+	SECTION("string weights and nodes with spaces") {
+		auto g = gdwg::graph<std::string, std::string>{"a b", "c", "  indented"};
+		g.insert_edge("a b", "c", "x y");
+		g.insert_edge("a b", "  indented");
+		g.insert_edge("  indented", "a b", "");
+		REQUIRE(round_trip(g) == g);
+	}
+
+	SECTION("double weights") {
+		auto g = gdwg::graph<int, double>{1, 2};
+		g.insert_edge(1, 2, 0.5);
+		g.insert_edge(1, 2, -1.25);
+		g.insert_edge(2, 1, 1e+20);
+		REQUIRE(round_trip(g) == g);
+	}
+
+	SECTION("char nodes") {
+		auto g = gdwg::graph<char, int>{'a', 'b'};
+		g.insert_edge('a', 'b', 7);
+		REQUIRE(round_trip(g) == g);
+	}
+
+	SECTION("an empty graph") {
+		auto const g = gdwg::graph<int, int>{};
+		REQUIRE(round_trip(g) == g);
+	}
+
+	SECTION("a node name longer than one block of input") {
+		auto const name = std::string(3 * gdwg::text::block_size, 'n');
+		auto g = gdwg::graph<std::string, int>{name, "m"};
+		g.insert_edge(name, "m", 1);
+		g.insert_edge("m", name, 2);
+		REQUIRE(round_trip(g) == g);
+	}
+}
+
+TEST_CASE("operator>> replaces the graph's contents", "[text]") {
+	auto g = sample_graph();
+	auto in = std::istringstream("\nx (\n  x -> x | U\n)\n");
+	in >> g;
+
+	REQUIRE(g.nodes() == std::vector<std::string>{"x"});
+	REQUIRE(g.is_connected("x", "x"));
+	REQUIRE(in.eof());
+}
+
+TEST_CASE("operator>> fails on text in another format and leaves the graph unchanged", "[text]") {
+	auto const input = GENERATE(std::string("A -> B | U\n"),
+	                            std::string("\nA (\n  A -> B | U\n"),
+	                            std::string("\nA (\n  B -> A | U\n)\n"),
+	                            std::string("\nA (\n  A -> B | W | x\n)\n"),
+	                            std::string("\nA (\n  A -> B\n)\n"),
+	                            std::string("\nA (\n)\nB\n"));
+	auto g = gdwg::graph<std::string, int>{"keep"};
+	auto in = std::istringstream(input);
+	in >> g;
+
+	REQUIRE(in.fail());
+	REQUIRE(g.nodes() == std::vector<std::string>{"keep"});
+}
+
+TEST_CASE("operator>> fails on a node that is not a valid N", "[text]") {
+	auto g = gdwg::graph<int, int>{};
+	auto in = std::istringstream("\nx (\n)\n");
+	in >> g;
+	REQUIRE(in.fail());
+}
+
+TEST_CASE("read_edge_list reads one edge per line", "[text][read_edge_list]") {
+	auto in = std::istringstream("# source target weight\n"
+	                             "1 2 5\n"
+	                             "\n"
+	                             "2\t3\r\n"
+	                             "  3   1   -7  \n"
+	                             "1 2 5\n"
+	                             "4 4");
+	auto const g = gdwg::read_edge_list<int, int>(in);
+
+	auto expected = gdwg::graph<int, int>{1, 2, 3, 4};
+	expected.insert_edge(1, 2, 5);
+	expected.insert_edge(2, 3);
+	expected.insert_edge(3, 1, -7);
+	expected.insert_edge(4, 4);
+	REQUIRE(g == expected);
+}
+
+TEST_CASE("read_edge_list names the first malformed line", "[text][read_edge_list]") {
+	SECTION("a missing destination") {
+		auto in = std::istringstream("a b 1\na\n");
+		REQUIRE_THROWS_WITH((gdwg::read_edge_list<std::string, int>(in)),
+		                    "Cannot call gdwg::read_edge_list on input with a malformed line 2");
+	}
+
+	SECTION("too many fields") {
+		auto in = std::istringstream("a b 1 2\n");
+		REQUIRE_THROWS_WITH((gdwg::read_edge_list<std::string, int>(in)),
+		                    "Cannot call gdwg::read_edge_list on input with a malformed line 1");
+	}
+
+	SECTION("a weight that is not a number") {
+		auto in = std::istringstream("1 2\n\n2 3 x\n");
+		REQUIRE_THROWS_WITH((gdwg::read_edge_list<int, int>(in)),
+		                    "Cannot call gdwg::read_edge_list on input with a malformed line 3");
+	}
+
+	SECTION("a node that is not a number") {
+		auto in = std::istringstream("1 2.5\n");
+		REQUIRE_THROWS_WITH((gdwg::read_edge_list<int, int>(in)),
+		                    "Cannot call gdwg::read_edge_list on input with a malformed line 1");
+	}
+}
+
+TEST_CASE("read_edge_list reads a file on several threads", "[text][read_edge_list]") {
+	auto const text = long_edge_list();
+	auto const file = temp_file("threads", text);
+	auto in = std::istringstream(text);
+	auto const expected = gdwg::read_edge_list<std::string, int>(in);
+
+	// More threads than lines leaves parts empty.
+	auto const threads = GENERATE(1U, 2U, 3U, 8U, 1000U);
+	REQUIRE(gdwg::read_edge_list<std::string, int>(file.path, threads) == expected);
+}
+
+TEST_CASE("read_edge_list on several threads names the first malformed line of the file", "[text][read_edge_list]") {
+	auto text = long_edge_list();
+	text += "a b c\n";
+	text += long_edge_list();
+	text += "d\n";
+	auto const file = temp_file("malformed", text);
+	auto in = std::istringstream(text);
+	REQUIRE_THROWS_WITH((gdwg::read_edge_list<std::string, int>(in)),
+	                    "Cannot call gdwg::read_edge_list on input with a malformed line 319");
+
+	auto const threads = GENERATE(1U, 2U, 5U);
+	REQUIRE_THROWS_WITH((gdwg::read_edge_list<std::string, int>(file.path, threads)),
+	                    "Cannot call gdwg::read_edge_list on input with a malformed line 319");
+}
+
+TEST_CASE("read_edge_list rejects a file that cannot be read", "[text][read_edge_list]") {
+	auto const path = std::filesystem::temp_directory_path() / "gdwg_text_test_missing";
+	REQUIRE_THROWS_WITH((gdwg::read_edge_list<int, int>(path, 2)),
+	                    "Cannot call gdwg::read_edge_list on a file that cannot be read");
+}